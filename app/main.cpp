@@ -26,6 +26,10 @@
 //
 #include "util/AbstractCheCalculator.h"
 #include "pf/ChePFCalculator.h"
+#include "pf/ChePFIslandCalculator.h"
+#include "pf/ChePFTimeSeries.h"
+#include "pf/ChePFContingency.h"
+#include "pf/ChePFContinuation.h"
 #include "io/MatPsatDataRW.h"
 #include "util/SafeArmadillo.h"
 #include "util/CheCompUtil.h"
@@ -181,6 +185,17 @@ int main(int argc, char **argv) {
 				}
 			} else if (arg == "--verbose" || arg == "-v") {
 				verbose = true;
+			} else if (arg == "--solver" || arg == "-b") {
+				if (++iArg < argc) {
+					int solverType = CheSparseSolverFactory::parseSolverType(argv[iArg]);
+					if (solverType >= 0) {
+						options.linearSolver = solverType;
+					} else {
+						cerr << "Unknown linear solver " << argv[iArg] << ". Using superlu as default." << endl;
+					}
+				} else {
+					cerr << "Linear solver should be specified after --solver or -b. Using superlu as default." << endl;
+				}
 			}
 		}
 
@@ -334,6 +349,19 @@ int main(int argc, char **argv) {
 		double diffTol = 1e-6;
 		double diffTolMax = 1e-2;
 		int repeat = 1;
+		bool islandParallel = false;
+		int nThreads = 0;
+		int solverType = CHESPSOLVER_SUPERLU;
+		int staleLuMaxIter = 0;
+		string warmPath = "";
+		string seriesPath = "";
+		bool chainWarmStart = false;
+		string contingencyPath = "";
+		string summaryPath = GetCurrentWorkingDir() + "/contingency.csv";
+		int lowRankMaxRank = 16;
+		double maxScale = 1.0;
+		double recordStep = 0.0;
+		bool enforceQLimits = false;
 		for (int iArg = 2; iArg < argc; iArg++) {
 			string arg = argv[iArg];
 			if (arg == "--file" || arg == "-f") {
@@ -385,6 +413,77 @@ int main(int argc, char **argv) {
 				} else {
 					cerr << "diffTolMax should be specified after --difftolmax or -e. Using diffTolMax=" << diffTolMax << " as default." << endl;
 				}
+			} else if (arg == "--islands" || arg == "-i") {
+				islandParallel = true;
+			} else if (arg == "--threads" || arg == "-t") {
+				if (++iArg < argc) {
+					nThreads = stoi(argv[iArg]);
+				} else {
+					cerr << "Number of threads should be specified after --threads or -t. Using all hardware threads as default." << endl;
+				}
+			} else if (arg == "--solver" || arg == "-b") {
+				if (++iArg < argc) {
+					solverType = CheSparseSolverFactory::parseSolverType(argv[iArg]);
+					if (solverType < 0) {
+						cerr << "Unknown linear solver " << argv[iArg] << ". Using superlu as default." << endl;
+						solverType = CHESPSOLVER_SUPERLU;
+					}
+				} else {
+					cerr << "Linear solver should be specified after --solver or -b. Using superlu as default." << endl;
+				}
+			} else if (arg == "--stalelu" || arg == "-k") {
+				if (++iArg < argc) {
+					staleLuMaxIter = stoi(argv[iArg]);
+				} else {
+					cerr << "Maximum iterations should be specified after --stalelu or -k. Stale LU mode is off." << endl;
+				}
+			} else if (arg == "--warm" || arg == "-w") {
+				if (++iArg < argc) {
+					warmPath = argv[iArg];
+				} else {
+					cerr << "Previous output file should be specified after --warm or -w. Using the flat start." << endl;
+				}
+			} else if (arg == "--series" || arg == "-q") {
+				if (++iArg < argc) {
+					seriesPath = argv[iArg];
+				} else {
+					cerr << "Profile file should be specified after --series or -q. Solving the single case." << endl;
+				}
+			} else if (arg == "--chain" || arg == "-c") {
+				chainWarmStart = true;
+			} else if (arg == "--contingency" || arg == "-n") {
+				if (++iArg < argc) {
+					contingencyPath = argv[iArg];
+				} else {
+					cerr << "Contingency file (or all) should be specified after --contingency or -n. Solving the single case." << endl;
+				}
+			} else if (arg == "--summary" || arg == "-u") {
+				if (++iArg < argc) {
+					string subArg = argv[iArg];
+					summaryPath = GetCurrentWorkingDir() + "/" + subArg;
+				} else {
+					cerr << "Summary file name should be specified after --summary or -u. Using contingency.csv as default." << endl;
+				}
+			} else if (arg == "--lowrank" || arg == "-x") {
+				if (++iArg < argc) {
+					lowRankMaxRank = stoi(argv[iArg]);
+				} else {
+					cerr << "Maximum rank should be specified after --lowrank or -x. Using " << lowRankMaxRank << " as default." << endl;
+				}
+			} else if (arg == "--continuation" || arg == "-y") {
+				if (++iArg < argc) {
+					maxScale = stod(argv[iArg]);
+				} else {
+					cerr << "Maximum load scale should be specified after --continuation or -y. Solving the single case." << endl;
+				}
+			} else if (arg == "--record" || arg == "-z") {
+				if (++iArg < argc) {
+					recordStep = stod(argv[iArg]);
+				} else {
+					cerr << "Load scale step should be specified after --record or -z. Only the margin is recorded." << endl;
+				}
+			} else if (arg == "--qlimits" || arg == "-j") {
+				enforceQLimits = true;
 			}
 		}
 
@@ -436,10 +535,117 @@ int main(int argc, char **argv) {
 
 		CheCompOptions compOpt(nlvl, 1.0, alphaTol, segment, diffTol, diffTolMax);
 
+		if (!seriesPath.empty()) {
+			if (islandParallel || repeat > 1) {
+				cerr << "--islands and --repeat are not used with --series." << endl;
+			}
+			ChePfTimeSeries series(psatData, compOpt, islands);
+			if (!series.readProfileMatFile(seriesPath.c_str())) {
+				return -1;
+			}
+			ChePfCalculator &pfCalculator = series.calculator;
+			pfCalculator.solverType = solverType;
+			pfCalculator.nSolverThreads = nThreads;
+			if (staleLuMaxIter > 0) {
+				pfCalculator.useStaleLu = true;
+				pfCalculator.staleLuMaxIter = staleLuMaxIter;
+			}
+			if (!warmPath.empty()) {
+				vec warmVec;
+				if (ChePfCalculator::readStateMatFile(warmPath.c_str(), warmVec)) {
+					pfCalculator.setWarmStart(CheState(pfCalculator.baseSys, warmVec));
+				}
+			}
+			pfCalculator.enforceQLimits = enforceQLimits;
+			series.chainWarmStart = chainWarmStart;
+			int nFailed = series.run(outputPath.c_str());
+			cout << "Time series: " << series.nPoints() - nFailed << " of " << series.nPoints() << " points converged." << endl;
+			cout << "Computation time: " << series.totalTime << " s." << endl;
+			return 0;
+		}
+
+		if (maxScale > 1.0) {
+			if (islandParallel || repeat > 1 || !warmPath.empty()) {
+				cerr << "--islands, --repeat and --warm are not used with --continuation." << endl;
+			}
+			if (enforceQLimits) {
+				cerr << "Q limits are not enforced with --continuation." << endl;
+			}
+			compOpt.maxAlpha = maxScale;
+			ChePfContinuation continuation(psatData, compOpt);
+			ChePfCalculator &pfCalculator = continuation.calculator;
+			pfCalculator.solverType = solverType;
+			pfCalculator.nSolverThreads = nThreads;
+			continuation.setRecordStep(recordStep);
+			pctimer_t stTime = pctimer();
+			continuation.run();
+			pctimer_t endTime = pctimer();
+			continuation.writeMatFile(outputPath.c_str());
+			cout << "Computation time: " << endTime - stTime << " s." << endl;
+			return 0;
+		}
+
+		if (!contingencyPath.empty()) {
+			if (islandParallel || repeat > 1 || !warmPath.empty()) {
+				cerr << "--islands, --repeat and --warm are not used with --contingency." << endl;
+			}
+			ChePfContingencyAnalysis contingency(psatData, compOpt, nThreads);
+			contingency.solverType = solverType;
+			contingency.lowRankMaxRank = lowRankMaxRank;
+			contingency.enforceQLimits = enforceQLimits;
+			if (contingencyPath == "all") {
+				contingency.addAllOutages();
+			} else if (!contingency.readContingencyMatFile(contingencyPath.c_str())) {
+				return -1;
+			}
+			pctimer_t stTime = pctimer();
+			int baseFlag = contingency.solveBase();
+			ChePfCalculator::writeStateMatFile(outputPath.c_str(), contingency.baseState.state);
+			if (baseFlag != 0) {
+				cerr << "Base case did not converge, contingencies are not solved." << endl;
+			} else {
+				contingency.run();
+			}
+			pctimer_t endTime = pctimer();
+			if (contingency.writeSummary(summaryPath.c_str())) {
+				cout << "Contingency summary written to file " << summaryPath << "." << endl;
+			}
+			cout << "Computation time: " << endTime - stTime << " s." << endl;
+			return 0;
+		}
+
 		pctimer_t totalTime = 0.;
 
 		for (int i = 0; i < repeat; i++) {
-			AbstractCheCalculator *pCalculator = new ChePfCalculator(psatData, compOpt, islands);
+			AbstractCheCalculator *pCalculator = NULL;
+			if (islandParallel && islands.max() > 0) {
+				ChePfIslandCalculator *pIslandCalculator = new ChePfIslandCalculator(psatData, compOpt, islands, nThreads);
+				pIslandCalculator->solverType = solverType;
+				pIslandCalculator->staleLuMaxIter = staleLuMaxIter;
+				if (!warmPath.empty()) {
+					cerr << "Warm start is not available with --islands, using the flat start." << endl;
+				}
+				if (enforceQLimits) {
+					cerr << "Q limits are not enforced with --islands." << endl;
+				}
+				pCalculator = pIslandCalculator;
+			} else {
+				ChePfCalculator *pPfCalculator = new ChePfCalculator(psatData, compOpt, islands);
+				pPfCalculator->solverType = solverType;
+				pPfCalculator->nSolverThreads = nThreads;
+				pPfCalculator->enforceQLimits = enforceQLimits;
+				if (staleLuMaxIter > 0) {
+					pPfCalculator->useStaleLu = true;
+					pPfCalculator->staleLuMaxIter = staleLuMaxIter;
+				}
+				if (!warmPath.empty()) {
+					vec warmVec;
+					if (ChePfCalculator::readStateMatFile(warmPath.c_str(), warmVec)) {
+						pPfCalculator->setWarmStart(CheState(pPfCalculator->baseSys, warmVec));
+					}
+				}
+				pCalculator = pPfCalculator;
+			}
 			pctimer_t stTime = pctimer();
 			int pfFlag = pCalculator->calc();
 			pctimer_t endTime = pctimer();
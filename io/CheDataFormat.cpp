@@ -30,7 +30,8 @@ namespace che {
 	namespace io {
 		namespace chedata {
 
-			int CheComponent::counter = 0;
+			std::atomic<int> CheComponent::counter(0);
+			std::atomic<long> PsatDataSet::contentCounter(0);
 
 		}
 	} // namespace io
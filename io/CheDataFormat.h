@@ -33,6 +33,10 @@
 #include <string>
 #include "util/SafeArmadillo.h"
 #include <map>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 
 using namespace std;
 using namespace arma;
@@ -48,7 +52,7 @@ namespace che {
 		namespace chedata {
 			class CheComponent {
 			public:
-				static int counter;
+				static std::atomic<int> counter; // components may be copied concurrently by island workers
 
 				CheComponent() {
 					regNewId();
@@ -575,124 +579,130 @@ namespace che {
 				Tg *tgs;
 				Exc *excs;
 
-				map<int, int> newToOld;
-				map<int, int> oldToNew;
+				// Bus renumbering maps, shared by copies of the set.
+				shared_ptr<const map<int, int>> newToOld;
+				shared_ptr<const map<int, int>> oldToNew;
 
 				bool isFormatted;
 
 			public:
 				PsatDataSet() {
-
-					nBus = -1;
-					nSw = -1;
-					nPv = -1;
-					nPq = -1;
-					nShunt = -1;
-					nLine = -1;
-					nPl = -1;
-					nSyn = -1;
-					nInd = -1;
-					nTg = -1;
-					nExc = -1;
-
-					newToOld = map<int, int>();
-					oldToNew = map<int, int>();
-
-					isFormatted = false;
+					contentId = ++contentCounter;
+					networkId = contentId;
+					init();
 				}
 
 				PsatDataSet(const PsatDataSet &psat, bool regNew = false) {
-					nBus = -1;
-					nSw = -1;
-					nPv = -1;
-					nPq = -1;
-					nShunt = -1;
-					nLine = -1;
-					nPl = -1;
-					nSyn = -1;
-					nInd = -1;
-					nTg = -1;
-					nExc = -1;
-
-					newToOld = map<int, int>();
-					oldToNew = map<int, int>();
-
-					isFormatted = false;
+					init();
 					copyMembers(psat, regNew);
 				}
 
 				PsatDataSet &operator=(const PsatDataSet &psat) {
-					nBus = -1;
-					nSw = -1;
-					nPv = -1;
-					nPq = -1;
-					nShunt = -1;
-					nLine = -1;
-					nPl = -1;
-					nSyn = -1;
-					nInd = -1;
-					nTg = -1;
-					nExc = -1;
-
-					newToOld = map<int, int>();
-					oldToNew = map<int, int>();
-
-					isFormatted = false;
-					copyMembers(psat, false);
+					if (this != &psat) {
+						copyMembers(psat, false);
+					}
 					return *this;
 				}
 
-				void renumberBuses(map<int, int> &oldToNew) {
+				void renumberBuses(const map<int, int> &oldToNew) {
 					map<int, int> busMap;
 					for (int i = 0; i < nBus; i++) {
 						busMap.insert(pair<int, int>(buses[i].busNumber, i + 1));
 					}
+					SW *psw = mutable_sws();
 					for (int i = 0; i < nSw; i++) {
-						sws[i].busNumber = busMap[sws[i].busNumber];
+						psw[i].busNumber = busMap[psw[i].busNumber];
 					}
+					PV *ppv = mutable_pvs();
 					for (int i = 0; i < nPv; i++) {
-						pvs[i].busNumber = busMap[pvs[i].busNumber];
+						ppv[i].busNumber = busMap[ppv[i].busNumber];
 					}
+					PQ *ppq = mutable_pqs();
 					for (int i = 0; i < nPq; i++) {
-						pqs[i].busNumber = busMap[pqs[i].busNumber];
+						ppq[i].busNumber = busMap[ppq[i].busNumber];
 					}
+					Shunt *pshunt = mutable_shunts();
 					for (int i = 0; i < nShunt; i++) {
-						shunts[i].busNumber = busMap[shunts[i].busNumber];
+						pshunt[i].busNumber = busMap[pshunt[i].busNumber];
 					}
+					Line *pline = mutable_lines();
 					for (int i = 0; i < nLine; i++) {
-						lines[i].fromBus = busMap[lines[i].fromBus];
-						lines[i].toBus = busMap[lines[i].toBus];
+						pline[i].fromBus = busMap[pline[i].fromBus];
+						pline[i].toBus = busMap[pline[i].toBus];
 					}
+					Pl *ppl = mutable_pls();
 					for (int i = 0; i < nPl; i++) {
-						pls[i].busNumber = busMap[pls[i].busNumber];
+						ppl[i].busNumber = busMap[ppl[i].busNumber];
 					}
+					Syn *psyn = mutable_syns();
 					for (int i = 0; i < nSyn; i++) {
-						syns[i].busNumber = busMap[syns[i].busNumber];
+						psyn[i].busNumber = busMap[psyn[i].busNumber];
 					}
+					Ind *pind = mutable_inds();
 					for (int i = 0; i < nInd; i++) {
-						inds[i].busNumber = busMap[inds[i].busNumber];
+						pind[i].busNumber = busMap[pind[i].busNumber];
 					}
+					shared_ptr<map<int, int>> newOldToNew;
 					if (oldToNew.empty()) {
-						this->oldToNew = busMap;
+						newOldToNew = make_shared<map<int, int>>(busMap);
 					} else {
-						map<int, int> tempMap;
-						map<int, int>::iterator itr;
+						newOldToNew = make_shared<map<int, int>>();
+						map<int, int>::const_iterator itr;
 						for (itr = oldToNew.begin(); itr != oldToNew.end(); ++itr) {
-							tempMap.insert(pair<int, int>(itr->first, busMap[itr->second]));
+							newOldToNew->insert(pair<int, int>(itr->first, busMap[itr->second]));
 						}
-						this->oldToNew.clear();
-						this->oldToNew = tempMap;
 					}
-					newToOld.clear();
+					shared_ptr<map<int, int>> newNewToOld = make_shared<map<int, int>>();
 					map<int, int>::iterator itr;
-					for (itr = this->oldToNew.begin(); itr != this->oldToNew.end(); ++itr) {
-						newToOld.insert(pair<int, int>(itr->second, itr->first));
+					for (itr = newOldToNew->begin(); itr != newOldToNew->end(); ++itr) {
+						newNewToOld->insert(pair<int, int>(itr->second, itr->first));
 					}
+					this->oldToNew = newOldToNew;
+					this->newToOld = newNewToOld;
 					isFormatted = true;
+					invalidateColumns();
 				}
 
 				void renumberBuses() {
-					renumberBuses(this->oldToNew);
+					renumberBuses(*this->oldToNew);
+				}
+
+				/**
+				 * @brief Drops the column caches of the get_*_vec accessors.
+				 *
+				 * The component arrays are the primary storage. Code that writes a component field or replaces
+				 * an array after an accessor was used must call this before the next accessor call.
+				 */
+				void invalidateColumns() {
+					invalidateInjections();
+					networkId = contentId;
+				}
+
+				/**
+				 * @brief Like invalidateColumns(), but keeps the network id.
+				 *
+				 * Only for writers that change injections or set-points (PQ, PV, SW, ZIP and machine fields) and
+				 * leave the lines alone, so that the Y matrix derived from the network stays valid.
+				 */
+				void invalidateInjections() {
+					std::lock_guard<std::mutex> lock(columnMutex);
+					vecColumns.clear();
+					uvecColumns.clear();
+					contentId = ++contentCounter;
+				}
+
+				/**
+				 * @brief Identifies the content of the dataset for caches of derived data.
+				 *
+				 * Copies keep the id of their source; every invalidateColumns() gives the dataset a new one.
+				 */
+				long getContentId() const {
+					return contentId;
+				}
+
+				/** @brief Identifies the network (lines) of the dataset for caches of the Y matrix. */
+				long getNetworkId() const {
+					return networkId;
 				}
 
 				virtual ~PsatDataSet() {
@@ -701,39 +711,67 @@ namespace che {
 
 				void reset() {
 					freeSpace();
-
-					nBus = -1;
-					nSw = -1;
-					nPv = -1;
-					nPq = -1;
-					nShunt = -1;
-					nLine = -1;
-					nPl = -1;
-					nSyn = -1;
-					nInd = -1;
-					nTg = -1;
-					nExc = -1;
-
-					newToOld = map<int, int>();
-					oldToNew = map<int, int>();
-
-					isFormatted = false;
+					invalidateColumns();
+					init();
 				}
 
-#define GET_FIELD_VEC(type, data, field, size) \
-	type get_##data##_##field##_vec() const {  \
-		type x(size > 0 ? size : 0);           \
-		for (int i = 0; i < size; i++)         \
-			x(i) = data[i].field;              \
-		return x;                              \
+				/*
+				 * Component tables are shared by copies of the set and copied on write. Reading through the
+				 * pointers is always allowed; writers obtain the table through alloc_*() (new table of n
+				 * entries), mutable_*() (private copy of the current table) or release_*() (no table), and call
+				 * invalidateColumns() when done.
+				 */
+#define COMPONENT_TABLE(type, data, size)                                        \
+	type *alloc_##data(int n) {                                                \
+		data##Table.reset();                                                   \
+		data = NULL;                                                           \
+		if (n > 0) {                                                           \
+			data##Table = shared_ptr<type>(new type[n], default_delete<type[]>()); \
+			data = data##Table.get();                                          \
+		}                                                                      \
+		size = n;                                                              \
+		return data;                                                           \
+	}                                                                          \
+	type *mutable_##data() {                                                   \
+		if (size > 0 && data##Table.use_count() > 1) {                         \
+			shared_ptr<type> table(new type[size], default_delete<type[]>());  \
+			std::copy(data, data + size, table.get());                         \
+			data##Table = table;                                               \
+			data = table.get();                                                \
+		}                                                                      \
+		return data;                                                           \
+	}                                                                          \
+	void release_##data() {                                                    \
+		data##Table.reset();                                                   \
+		data = NULL;                                                           \
+		size = -1;                                                             \
+	}
+				COMPONENT_TABLE(Bus, buses, nBus);
+				COMPONENT_TABLE(SW, sws, nSw);
+				COMPONENT_TABLE(PV, pvs, nPv);
+				COMPONENT_TABLE(PQ, pqs, nPq);
+				COMPONENT_TABLE(Shunt, shunts, nShunt);
+				COMPONENT_TABLE(Line, lines, nLine);
+				COMPONENT_TABLE(Pl, pls, nPl);
+				COMPONENT_TABLE(Syn, syns, nSyn);
+				COMPONENT_TABLE(Ind, inds, nInd);
+				COMPONENT_TABLE(Tg, tgs, nTg);
+				COMPONENT_TABLE(Exc, excs, nExc);
+
+#define GET_FIELD_VEC(type, data, field, size)                  \
+	const type &get_##data##_##field##_vec() const {           \
+		return getColumn<type>(#data "." #field, [this](type &x) { \
+			for (int i = 0; i < size; i++)                      \
+				x(i) = data[i].field;                           \
+		}, size);                                               \
 	}
 
-#define GET_UNION_SUBFIELD_VEC(type, data, un, field, subf, size) \
-	type get_##data##_##un##_##field##_##subf##_vec() const {     \
-		type x(size > 0 ? size : 0);                              \
-		for (int i = 0; i < size; i++)                            \
-			x(i) = data[i].un.field.subf;                         \
-		return x;                                                 \
+#define GET_UNION_SUBFIELD_VEC(type, data, un, field, subf, size)                      \
+	const type &get_##data##_##un##_##field##_##subf##_vec() const {                   \
+		return getColumn<type>(#data "." #un "." #field "." #subf, [this](type &x) { \
+			for (int i = 0; i < size; i++)                                              \
+				x(i) = data[i].un.field.subf;                                           \
+		}, size);                                                                       \
 	}
 				// Bus
 				GET_FIELD_VEC(uvec, buses, busNumber, nBus);
@@ -926,114 +964,132 @@ namespace che {
 				GET_UNION_SUBFIELD_VEC(vec, excs, excData, exc3, Tr, nExc);
 
 			private:
-				void freeSpace() {
-					if (nBus > 0) {
-						delete[] buses;
-					}
-					if (nSw > 0) {
-						delete[] sws;
-					}
-					if (nPv > 0) {
-						delete[] pvs;
-					}
-					if (nPq > 0) {
-						delete[] pqs;
-					}
-					if (nShunt > 0) {
-						delete[] shunts;
-					}
-					if (nLine > 0) {
-						delete[] lines;
-					}
-					if (nPl > 0) {
-						delete[] pls;
-					}
-					if (nSyn > 0) {
-						delete[] syns;
-					}
-					if (nInd > 0) {
-						delete[] inds;
+				static std::atomic<long> contentCounter;
+				long contentId;
+				long networkId;
+
+				// Columns of the get_*_vec accessors, built on first use and shared by all later calls, keyed
+				// by the field name ("table.field"), which is the same in every translation unit.
+				mutable std::mutex columnMutex;
+				mutable map<string, vec> vecColumns;
+				mutable map<string, uvec> uvecColumns;
+
+				map<string, vec> &columnCache(vec *) const {
+					return vecColumns;
+				}
+
+				map<string, uvec> &columnCache(uvec *) const {
+					return uvecColumns;
+				}
+
+				template <typename T, typename F>
+				const T &getColumn(const string &key, F fillColumn, int size) const {
+					std::lock_guard<std::mutex> lock(columnMutex);
+					map<string, T> &cache = columnCache((T *)NULL);
+					typename map<string, T>::iterator itr = cache.find(key);
+					if (itr == cache.end()) {
+						T x(size > 0 ? size : 0);
+						fillColumn(x);
+						itr = cache.insert(make_pair(key, x)).first;
 					}
-					if (nTg > 0) {
-						delete[] tgs;
+					return itr->second;
+				}
+
+				shared_ptr<Bus> busesTable;
+				shared_ptr<SW> swsTable;
+				shared_ptr<PV> pvsTable;
+				shared_ptr<PQ> pqsTable;
+				shared_ptr<Shunt> shuntsTable;
+				shared_ptr<Line> linesTable;
+				shared_ptr<Pl> plsTable;
+				shared_ptr<Syn> synsTable;
+				shared_ptr<Ind> indsTable;
+				shared_ptr<Tg> tgsTable;
+				shared_ptr<Exc> excsTable;
+
+				void init() {
+					nBus = -1;
+					nSw = -1;
+					nPv = -1;
+					nPq = -1;
+					nShunt = -1;
+					nLine = -1;
+					nPl = -1;
+					nSyn = -1;
+					nInd = -1;
+					nTg = -1;
+					nExc = -1;
+
+					buses = NULL;
+					sws = NULL;
+					pvs = NULL;
+					pqs = NULL;
+					shunts = NULL;
+					lines = NULL;
+					pls = NULL;
+					syns = NULL;
+					inds = NULL;
+					tgs = NULL;
+					excs = NULL;
+
+					newToOld = make_shared<map<int, int>>();
+					oldToNew = make_shared<map<int, int>>();
+
+					isFormatted = false;
+				}
+
+				void freeSpace() {
+					release_buses();
+					release_sws();
+					release_pvs();
+					release_pqs();
+					release_shunts();
+					release_lines();
+					release_pls();
+					release_syns();
+					release_inds();
+					release_tgs();
+					release_excs();
+				}
+
+				template <typename T>
+				void copyTable(shared_ptr<T> &table, T *&data, int &size, const shared_ptr<T> &srcTable, const T *srcData, int srcSize, bool regNew) {
+					size = srcSize;
+					if (!regNew) {
+						table = srcTable;
+						data = table.get();
+						return;
 					}
-					if (nExc > 0) {
-						delete[] excs;
+					table.reset();
+					data = NULL;
+					if (size > 0) {
+						table = shared_ptr<T>(new T[size], default_delete<T[]>());
+						data = table.get();
+						for (int i = 0; i < size; i++)
+							data[i] = T(srcData[i], regNew);
 					}
 				}
 
+				// Shares the component tables of psat, or copies them with new component ids if regNew is set.
 				void copyMembers(const PsatDataSet &psat, bool regNew) {
 					reset();
-					this->nBus = psat.nBus;
-					if (this->nBus > 0) {
-						this->buses = new Bus[this->nBus];
-						for (int i = 0; i < this->nBus; i++)
-							this->buses[i] = Bus(psat.buses[i], regNew);
-					}
-					this->nSw = psat.nSw;
-					if (this->nSw > 0) {
-						this->sws = new SW[this->nSw];
-						for (int i = 0; i < this->nSw; i++)
-							this->sws[i] = SW(psat.sws[i], regNew);
-					}
-					this->nPv = psat.nPv;
-					if (this->nPv > 0) {
-						this->pvs = new PV[this->nPv];
-						for (int i = 0; i < this->nPv; i++)
-							this->pvs[i] = PV(psat.pvs[i], regNew);
-					}
-					this->nPq = psat.nPq;
-					if (this->nPq > 0) {
-						this->pqs = new PQ[this->nPq];
-						for (int i = 0; i < this->nPq; i++)
-							this->pqs[i] = PQ(psat.pqs[i], regNew);
-					}
-					this->nShunt = psat.nShunt;
-					if (this->nShunt > 0) {
-						this->shunts = new Shunt[this->nShunt];
-						for (int i = 0; i < this->nShunt; i++)
-							this->shunts[i] = Shunt(psat.shunts[i], regNew);
-					}
-					this->nLine = psat.nLine;
-					if (this->nLine > 0) {
-						this->lines = new Line[this->nLine];
-						for (int i = 0; i < this->nLine; i++)
-							this->lines[i] = Line(psat.lines[i], regNew);
-					}
-					this->nPl = psat.nPl;
-					if (this->nPl > 0) {
-						this->pls = new Pl[this->nPl];
-						for (int i = 0; i < this->nPl; i++)
-							this->pls[i] = Pl(psat.pls[i], regNew);
-					}
-					this->nSyn = psat.nSyn;
-					if (this->nSyn > 0) {
-						this->syns = new Syn[this->nSyn];
-						for (int i = 0; i < this->nSyn; i++)
-							this->syns[i] = Syn(psat.syns[i], regNew);
-					}
-					this->nInd = psat.nInd;
-					if (this->nInd > 0) {
-						this->inds = new Ind[this->nInd];
-						for (int i = 0; i < this->nInd; i++)
-							this->inds[i] = Ind(psat.inds[i], regNew);
-					}
-					this->nTg = psat.nTg;
-					if (this->nTg > 0) {
-						this->tgs = new Tg[this->nTg];
-						for (int i = 0; i < this->nTg; i++)
-							this->tgs[i] = Tg(psat.tgs[i], regNew);
-					}
-					this->nExc = psat.nExc;
-					if (this->nExc > 0) {
-						this->excs = new Exc[this->nExc];
-						for (int i = 0; i < this->nExc; i++)
-							this->excs[i] = Exc(psat.excs[i], regNew);
-					}
+					copyTable(busesTable, buses, nBus, psat.busesTable, psat.buses, psat.nBus, regNew);
+					copyTable(swsTable, sws, nSw, psat.swsTable, psat.sws, psat.nSw, regNew);
+					copyTable(pvsTable, pvs, nPv, psat.pvsTable, psat.pvs, psat.nPv, regNew);
+					copyTable(pqsTable, pqs, nPq, psat.pqsTable, psat.pqs, psat.nPq, regNew);
+					copyTable(shuntsTable, shunts, nShunt, psat.shuntsTable, psat.shunts, psat.nShunt, regNew);
+					copyTable(linesTable, lines, nLine, psat.linesTable, psat.lines, psat.nLine, regNew);
+					copyTable(plsTable, pls, nPl, psat.plsTable, psat.pls, psat.nPl, regNew);
+					copyTable(synsTable, syns, nSyn, psat.synsTable, psat.syns, psat.nSyn, regNew);
+					copyTable(indsTable, inds, nInd, psat.indsTable, psat.inds, psat.nInd, regNew);
+					copyTable(tgsTable, tgs, nTg, psat.tgsTable, psat.tgs, psat.nTg, regNew);
+					copyTable(excsTable, excs, nExc, psat.excsTable, psat.excs, psat.nExc, regNew);
 
 					this->newToOld = psat.newToOld;
 					this->oldToNew = psat.oldToNew;
 					this->isFormatted = psat.isFormatted;
+					this->contentId = psat.contentId;
+					this->networkId = psat.networkId;
 				}
 			};
 		} // namespace chedata
@@ -77,7 +77,7 @@ namespace che {
 				psatData->nBus = matvar->dims[0];
 				matdata = (double *)matvar->data;
 				if (psatData->nBus > 0) {
-					psatData->buses = new Bus[psatData->nBus];
+					psatData->alloc_buses(psatData->nBus);
 					for (int row = 0; row < psatData->nBus; row++) {
 						int col = 0;
 						psatData->buses[row].busNumber = (int)NEXT_C;
@@ -107,7 +107,7 @@ namespace che {
 					psatData->nSw = matvar->dims[0];
 					matdata = (double *)matvar->data;
 					if (psatData->nSw > 0) {
-						psatData->sws = new SW[psatData->nSw];
+						psatData->alloc_sws(psatData->nSw);
 						for (int row = 0; row < psatData->nSw; row++) {
 							int col = 0;
 							psatData->sws[row].busNumber = (int)NEXT_C;
@@ -145,7 +145,7 @@ namespace che {
 					psatData->nPv = matvar->dims[0];
 					matdata = (double *)matvar->data;
 					if (psatData->nPv > 0) {
-						psatData->pvs = new PV[psatData->nPv];
+						psatData->alloc_pvs(psatData->nPv);
 						for (int row = 0; row < psatData->nPv; row++) {
 							int col = 0;
 							psatData->pvs[row].busNumber = (int)NEXT_C;
@@ -181,7 +181,7 @@ namespace che {
 					psatData->nPq = matvar->dims[0];
 					matdata = (double *)matvar->data;
 					if (psatData->nPq > 0) {
-						psatData->pqs = new PQ[psatData->nPq];
+						psatData->alloc_pqs(psatData->nPq);
 						for (int row = 0; row < psatData->nPq; row++) {
 							int col = 0;
 							psatData->pqs[row].busNumber = (int)NEXT_C;
@@ -215,7 +215,7 @@ namespace che {
 					psatData->nShunt = matvar->dims[0];
 					matdata = (double *)matvar->data;
 					if (psatData->nShunt > 0) {
-						psatData->shunts = new Shunt[psatData->nShunt];
+						psatData->alloc_shunts(psatData->nShunt);
 						for (int row = 0; row < psatData->nShunt; row++) {
 							int col = 0;
 							psatData->shunts[row].busNumber = (int)NEXT_C;
@@ -247,7 +247,7 @@ namespace che {
 					psatData->nLine = matvar->dims[0];
 					matdata = (double *)matvar->data;
 					if (psatData->nLine > 0) {
-						psatData->lines = new Line[psatData->nLine];
+						psatData->alloc_lines(psatData->nLine);
 						for (int row = 0; row < psatData->nLine; row++) {
 							int col = 0;
 							psatData->lines[row].fromBus = (int)NEXT_C;
@@ -288,7 +288,7 @@ namespace che {
 					psatData->nPl = matvar->dims[0];
 					matdata = (double *)matvar->data;
 					if (psatData->nPl > 0) {
-						psatData->pls = new Pl[psatData->nPl];
+						psatData->alloc_pls(psatData->nPl);
 						for (int row = 0; row < psatData->nPl; row++) {
 							int col = 0;
 							psatData->pls[row].busNumber = (int)NEXT_C;
@@ -325,7 +325,7 @@ namespace che {
 					psatData->nSyn = matvar->dims[0];
 					matdata = (double *)matvar->data;
 					if (psatData->nSyn > 0) {
-						psatData->syns = new Syn[psatData->nSyn];
+						psatData->alloc_syns(psatData->nSyn);
 						for (int row = 0; row < psatData->nSyn; row++) {
 							int col = 0;
 							psatData->syns[row].busNumber = (int)NEXT_C;
@@ -378,7 +378,7 @@ namespace che {
 					psatData->nInd = matvar->dims[0];
 					matdata = (double *)matvar->data;
 					if (psatData->nInd > 0) {
-						psatData->inds = new Ind[psatData->nInd];
+						psatData->alloc_inds(psatData->nInd);
 						for (int row = 0; row < psatData->nInd; row++) {
 							int col = 0;
 							psatData->inds[row].busNumber = (int)NEXT_C;
@@ -423,7 +423,7 @@ namespace che {
 					psatData->nTg = matvar->dims[0];
 					matdata = (double *)matvar->data;
 					if (psatData->nTg > 0) {
-						psatData->tgs = new Tg[psatData->nTg];
+						psatData->alloc_tgs(psatData->nTg);
 						for (int row = 0; row < psatData->nTg; row++) {
 							int col = 0;
 							psatData->tgs[row].synNumber = (int)NEXT_C;
@@ -478,7 +478,7 @@ namespace che {
 					psatData->nExc = matvar->dims[0];
 					matdata = (double *)matvar->data;
 					if (psatData->nExc > 0) {
-						psatData->excs = new Exc[psatData->nExc];
+						psatData->alloc_excs(psatData->nExc);
 						for (int row = 0; row < psatData->nExc; row++) {
 							int col = 0;
 							psatData->excs[row].synNumber = (int)NEXT_C;
@@ -528,6 +528,7 @@ namespace che {
 				}
 
 				Mat_Close(matfp);
+				psatData->invalidateColumns();
 
 				return CHE_IO_SUCCESS;
 			}
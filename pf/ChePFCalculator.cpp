@@ -26,7 +26,12 @@
 //
 #include "pf/ChePFCalculator.h"
 #include "util/CheCompUtil.h"
+#include "util/CheConvolutionPlan.h"
+#include "util/CheConvKernel.h"
+#include "util/CheSmallMatKernel.h"
+#include "util/CheSparseSolver.h"
 #include "matio.h"
+#include "nvwa/pctimer.h"
 // #include "slu_ddefs.h"
 
 // #define DEBUG_VERBOSE
@@ -41,118 +46,46 @@
 namespace che {
 	namespace core {
 		ChePfEmbedSystem::ChePfEmbedSystem(const chedata::PsatDataSet &sys)
-			: CheSingleEmbedSystem(CheState(sys), sys, 0.0) {
-			initState.state(initState.stateIdx.vrIdx).fill(1.0);
-			initState.state(initState.stateIdx.mEfIdx).fill(1.0);
+			: CheSingleEmbedSystem(CheState(sys, PF_STATE_BLOCKS), sys, 0.0) {
+			initState.getBlock(initState.stateIdx->vrIdx).fill(1.0);
+			initState.getBlock(initState.stateIdx->mEfIdx).fill(1.0);
+			residualEval = ChePfResidualEvaluator(baseSys, yMatrix, *initState.stateIdx);
 		}
 
 		ChePfEmbedSystem::ChePfEmbedSystem(const chedata::PsatDataSet &sys, const CheState &st, double alpha)
-			: CheSingleEmbedSystem(st, sys, alpha) {}
-
-		vec ChePfEmbedSystem::calcEqBalance(CheSolution *sol, double alpha) {
-			double absA = startAlpha + alpha;
-
-			vec solVal = sol->getSolValue(alpha);
-			CheState curState(baseSys, solVal);
-
-			uvec busType(baseSys.nBus, fill::zeros);
-			busType(C_IDX(baseSys.get_pvs_busNumber_vec())).fill(1);
-			busType(C_IDX(baseSys.get_sws_busNumber_vec())).fill(2);
-			vec pVec(baseSys.nBus, fill::zeros);
-			vec qVec(baseSys.nBus, fill::zeros);
-
-			pVec(C_IDX(baseSys.get_pvs_busNumber_vec())) += absA * baseSys.get_pvs_P_vec();
-			pVec(C_IDX(baseSys.get_pqs_busNumber_vec())) -= absA * baseSys.get_pqs_P_vec();
-			qVec(C_IDX(baseSys.get_pqs_busNumber_vec())) -= absA * baseSys.get_pqs_Q_vec();
-			if (baseSys.nPl > 0) {
-				pVec(C_IDX(baseSys.get_pls_busNumber_vec())) -= absA * baseSys.get_pls_P_vec() %
-																conv_to<vec>::from(baseSys.get_pls_status_vec());
-				qVec(C_IDX(baseSys.get_pls_busNumber_vec())) -= absA * baseSys.get_pls_Q_vec() %
-																conv_to<vec>::from(baseSys.get_pls_status_vec());
-			}
-			cx_vec V = cx_vec(curState.getSubVec(curState.stateIdx.vrIdx), curState.getSubVec(curState.stateIdx.viIdx));
-			sp_cx_mat Y = yMatrix.Ytr;
-			cx_vec Ysh = yMatrix.Ysh;
-			cx_vec YshShunt(baseSys.get_shunts_g_vec(), baseSys.get_shunts_b_vec());
+			: CheSingleEmbedSystem(st, sys, alpha) {
+			residualEval = ChePfResidualEvaluator(baseSys, yMatrix, *initState.stateIdx);
+		}
 
-			Ysh(C_IDX(baseSys.get_shunts_busNumber_vec())) += YshShunt;
-			if (baseSys.nPl > 0) {
-				Ysh(C_IDX(baseSys.get_pls_busNumber_vec())) += cx_vec(baseSys.get_pls_g_vec(), baseSys.get_pls_b_vec());
+		ChePfEmbedSystem::ChePfEmbedSystem(const chedata::PsatDataSet &sys, const CheState &st, double alpha, const CheState &warmBase)
+			: CheSingleEmbedSystem(st, sys, alpha), warmBase(warmBase) {
+			residualEval = ChePfResidualEvaluator(baseSys, yMatrix, *initState.stateIdx);
+			if (!warmBase.state.is_empty()) {
+				residualEval.setWarmBase(warmBase.state);
 			}
-			Y.diag() += absA * Ysh;
-			cx_vec IInj = Y * V;
-			IInj(C_IDX(baseSys.get_pls_busNumber_vec())) += absA *
-															cx_vec(baseSys.get_pls_Ip_vec(), -baseSys.get_pls_Iq_vec()) %
-															conv_to<vec>::from(baseSys.get_pls_status_vec()) %
-															V(C_IDX(baseSys.get_pls_busNumber_vec())) / abs(V(C_IDX(baseSys.get_pls_busNumber_vec())));
-			cx_vec SInjRHS = V % conj(IInj);
-			if (baseSys.nSyn > 0) {
-				uvec synIdx = C_IDX(baseSys.get_syns_busNumber_vec());
-				vec Efq = curState.getSubVec(curState.stateIdx.mEfIdx);
-				vec Efd = 0 * Efq;
-				vec d = curState.getSubVec(curState.stateIdx.mDeltaIdx);
-				vec cosd = cos(d);
-				vec sind = sin(d);
-				vec Cm = real(V(synIdx));
-				vec Dm = imag(V(synIdx));
-				vec Vd = sind % Cm - cosd % Dm;
-				vec Vq = cosd % Cm + sind % Dm;
-				vec Rs = baseSys.get_syns_ra_vec();
-				vec Xq = baseSys.get_syns_xq_vec();
-				vec Xd = baseSys.get_syns_xd_vec();
-				vec Id = (Rs % (Efd - Vd) + Xq % (Efq - Vq)) / (Rs % Rs + Xq % Xd);
-				vec Iq = (-Xd % (Efd - Vd) + Rs % (Efq - Vq)) / (Rs % Rs + Xq % Xd);
-				cx_vec Ig(sind % Id + cosd % Iq, -cosd % Id + sind % Iq);
-				SInjRHS(synIdx) -= V(synIdx) % conj(Ig);
-			}
-			vec diffTind;
-			if (baseSys.nInd > 0) {
-				// single-cage
-				// TODO: deal with double-cage
-				vec s = curState.getSubVec(curState.stateIdx.sIdx);
-				uvec indIdx = C_IDX(baseSys.get_inds_busNumber_vec());
-				vec R1 = baseSys.get_inds_rs_vec();
-				vec X1 = baseSys.get_inds_xs_vec();
-				vec Xm = baseSys.get_inds_xm_vec();
-				cx_vec Ym(0 / Xm, -absA / Xm);
-				vec R2 = baseSys.get_inds_rr1_vec();
-				vec X2 = baseSys.get_inds_xr1_vec();
-				vec T0 = baseSys.get_inds_Ta_vec() + baseSys.get_inds_Tb_vec() + baseSys.get_inds_Tc_vec();
-				vec T1 = -baseSys.get_inds_Tb_vec() - 2 * baseSys.get_inds_Tc_vec();
-				vec T2 = baseSys.get_inds_Tc_vec();
-				cx_vec Y2 = s / (cx_vec(R2, s % X2));
-				cx_vec Ytotal = (Ym + Y2) / (cx_vec(R1, X1) % (Ym + Y2) + 1.0);
-				cx_vec ILind = V(indIdx) % Ytotal;
-				SInjRHS(indIdx) += V(indIdx) % conj(ILind);
-
-				cx_vec Veind = V(indIdx) - ILind % cx_vec(R1, X1);
-				cx_vec IRs = Veind % Y2;
-				diffTind = real(IRs % conj(IRs) % R2 - absA * (T0 + s % (T1 + s % T2)) % s);
-			} else {
-				diffTind = vec();
-			}
-
-			// qVec(find(busType > 0)).fill(0.);
-			vec Q = curState.getSubVec(curState.stateIdx.qIdx);
-			SInjRHS -= cx_vec(pVec, qVec + Q);
-			SInjRHS(find(busType == 2)).fill(0.);
+		}
 
-			vec diffV;
-			if (baseSys.nPv > 0) {
-				uvec pvIdx = C_IDX(baseSys.get_pvs_busNumber_vec());
-				diffV = absA * (baseSys.get_pvs_vMag_vec() % baseSys.get_pvs_vMag_vec() - 1) + 1 - real(V(pvIdx) % conj(V(pvIdx)));
-			} else {
-				diffV = vec();
-			}
+		vec ChePfEmbedSystem::calcEqBalance(CheSolution *sol, double alpha) {
+			return residualEval.evaluate(sol->getSolValue(alpha), startAlpha + alpha);
+		}
 
-			return join_cols(real(SInjRHS), imag(SInjRHS), diffV, diffTind);
+		mat ChePfEmbedSystem::calcEqBalances(CheSolution *sol, const vec &alphas) {
+			return residualEval.evaluateBatch(sol->getSolValues(alphas), startAlpha + alphas);
 		}
 
 		CheSingleEmbedSystem *ChePfEmbedSystem::getNewEmbeddedSystem(const CheState &st, double alpha) {
-			CheSingleEmbedSystem *embSys = new ChePfEmbedSystem(baseSys, st, startAlpha + alpha);
+			ChePfEmbedSystem *embSys = new ChePfEmbedSystem(baseSys, st, startAlpha + alpha, warmBase);
+			if (!qClamp.is_empty()) {
+				embSys->setQClamp(qClamp);
+			}
 			return embSys;
 		}
 
+		void ChePfEmbedSystem::setQClamp(const vec &qClamp) {
+			this->qClamp = qClamp;
+			residualEval.setQClamp(qClamp);
+		}
+
 		ChePfCalculator::ChePfCalculator(const chedata::PsatDataSet &sys,
 										 const CheCompOptions &compOpt,
 										 const vec &ef, const vec &pm) : ChePfCalculator(sys, compOpt, CheCompUtil::searchIslands(sys), ef, pm) {
@@ -191,16 +124,73 @@ namespace che {
 
 			// this->baseSys = regulateIsland(this->baseSys);
 
-			perm_c = NULL;
-			perm_r = NULL;
-			etree = NULL;
+			solverType = CHESPSOLVER_SUPERLU;
+			nSolverThreads = 0;
+			linSolver = NULL;
+			genSolver = NULL;
+			levelTime = 0.0;
+			nLevels = 0;
+			useStaleLu = false;
+			staleLuMaxIter = 20;
+			staleLuTol = 1e-10;
+			nStaleLuSaved = 0;
+			nStaleLuFallback = 0;
+			staleLuIterations = 0;
+			minStep = 0.0;
+			alphaReached = 0.0;
+			enforceQLimits = false;
+			maxQLimitRounds = 10;
+			nQLimitSwitches = 0;
 		}
 
 		CheSingleEmbedSystem *ChePfCalculator::getInitSystem(const chedata::PsatDataSet &sys) {
-			CheSingleEmbedSystem *embSys = new ChePfEmbedSystem(sys);
+			ChePfEmbedSystem *embSys;
+			if (warmState.state.is_empty()) {
+				embSys = new ChePfEmbedSystem(sys);
+			} else {
+				embSys = new ChePfEmbedSystem(sys, warmState, 0.0, warmState);
+			}
+			if (!qClamp.is_empty()) {
+				embSys->setQClamp(qClamp);
+			}
 			return embSys;
 		}
 
+		bool ChePfCalculator::setWarmStart(const CheState &prev) {
+			shared_ptr<const CheStateIdx> pfIdx = CheCompUtil::getSharedStateIdx(baseSys, PF_STATE_BLOCKS);
+			const CheStateIdx &prevIdx = *prev.stateIdx;
+			if ((int)prev.state.n_rows != prevIdx.nState || prevIdx.vrIdx.n_rows != pfIdx->vrIdx.n_rows ||
+				prevIdx.sIdx.n_rows != pfIdx->sIdx.n_rows || prevIdx.mDeltaIdx.n_rows != pfIdx->mDeltaIdx.n_rows ||
+				prevIdx.mPgIdx.n_rows != pfIdx->mPgIdx.n_rows || prevIdx.mEfIdx.n_rows != pfIdx->mEfIdx.n_rows) {
+				cerr << logTag << "Warm start state does not match the system, using the flat start." << endl;
+				warmState = CheState();
+				return false;
+			}
+			warmState = CheState(pfIdx, CheCompUtil::mapState(prev.state, prevIdx, *pfIdx));
+			return true;
+		}
+
+		void ChePfCalculator::resetStages() {
+			for (auto &&che : cheList) {
+				if (che != NULL)
+					delete che;
+			}
+			cheList.clear();
+			for (auto &&sol : solList) {
+				if (sol != NULL)
+					delete sol;
+			}
+			solList.clear();
+			reachesMaxAlpha = false;
+			levelTime = 0.0;
+			nLevels = 0;
+			nStaleLuSaved = 0;
+			nStaleLuFallback = 0;
+			staleLuIterations = 0;
+			alphaReached = 0.0;
+			trajStates.reset();
+		}
+
 		chedata::PsatDataSet ChePfCalculator::regulateIsland(const chedata::PsatDataSet &sys) {
 			chedata::PsatDataSet newSys(sys);
 			if (!newSys.isFormatted) {
@@ -229,35 +219,31 @@ namespace che {
 				this->paraPm += extraPg;
 				DEBUG_PRINT_MAT(this->paraPm)
 
+				// Only the SW and PV tables are rebuilt; the other tables stay shared with sys.
 				if (newSys.nSw > 0) {
 					if (nSwNew <= 0) {
-						newSys.nSw = -1;
-						delete[] newSys.sws;
+						newSys.release_sws();
 					} else if (nSwNew < newSys.nSw) {
-						chedata::SW *psw = new chedata::SW[nSwNew];
+						chedata::PsatDataSet oldSw(newSys);
+						chedata::SW *psw = newSys.alloc_sws(nSwNew);
 						for (int i = 0; i < nSwNew; i++) {
-							psw[i] = chedata::SW(newSys.sws[swIdxNew(i)]);
+							psw[i] = chedata::SW(oldSw.sws[swIdxNew(i)]);
 						}
-						newSys.nSw = nSwNew;
-						delete[] newSys.sws;
-						newSys.sws = psw;
 					}
 				}
 				if (newSys.nPv > 0) {
 					if (nPvNew <= 0) {
-						newSys.nPv = -1;
-						delete[] newSys.pvs;
+						newSys.release_pvs();
 					} else if (nPvNew < newSys.nPv) {
-						chedata::PV *ppv = new chedata::PV[nPvNew];
+						chedata::PsatDataSet oldPv(newSys);
+						chedata::PV *ppv = newSys.alloc_pvs(nPvNew);
 						for (int i = 0; i < nPvNew; i++) {
-							ppv[i] = chedata::PV(newSys.pvs[pvIdxNew(i)]);
+							ppv[i] = chedata::PV(oldPv.pvs[pvIdxNew(i)]);
 						}
-						newSys.nPv = nPvNew;
-						delete[] newSys.pvs;
-						newSys.pvs = ppv;
 					}
 				}
 			}
+			newSys.invalidateColumns();
 			return newSys;
 		}
 
@@ -331,22 +317,20 @@ namespace che {
 			return cosp;
 		}
 
-		static void bicgstab(const sp_mat &A, vec &x, vec &b, arma::superlu::trans_t trans,
-							 arma::superlu::SuperMatrix *L, arma::superlu::SuperMatrix *U, int *perm_c, int *perm_r,
-							 arma::superlu::SuperLUStat_t *stat, int *info, int max_it, double tol, double *err, int *iter, int *flag) {
+		// Right-preconditioned BiCGSTAB, the preconditioner is applied through the factorization held by precond
+		// (typically the LU of an earlier, similar matrix).
+		static void bicgstab(const sp_mat &A, vec &x, const vec &b, CheSparseSolver &precond,
+							 int max_it, double tol, double *err, int *iter, int *flag) {
 
 			*iter = 0;
 			*flag = 0;
 			double bnrm2 = norm(b);
-			// A.print("A");
-			vec kk = A * x;
-			// b.print("b");
-			// kk.print("kk");
-			// x.print("x");
-			// b.print("b");
-			vec r(b);
-			r -= kk;
-			// r.print("r");
+			if (bnrm2 == 0.0) {
+				x.zeros(b.n_rows);
+				*err = 0.0;
+				return;
+			}
+			vec r = b - A * x;
 			*err = norm(r) / bnrm2;
 			if (*err < tol) {
 				return;
@@ -360,12 +344,6 @@ namespace che {
 			double alpha = 0.0;
 			vec p, v, s, t, p_hat, s_hat;
 
-			superlu_opts superlu_opts_default;
-			arma::superlu::superlu_options_t options;
-			sp_auxlib::set_superlu_opts(options, superlu_opts_default);
-			options.IterRefine = arma::superlu::NOREFINE;
-			options.RefineInitialized = arma::superlu::NO;
-
 			for (; *iter < max_it; *iter += 1) {
 				// iteration of the algorithm
 				rho = dot(r_tld, r);
@@ -378,49 +356,29 @@ namespace che {
 				} else {
 					p = r;
 				}
-				// p.print("p");
-
-				vec xx = p;
-				arma::superlu::SuperMatrix superX1;
-				arrayops::inplace_set(reinterpret_cast<char *>(&superX1), char(0), sizeof(arma::superlu::SuperMatrix));
 
-				const bool status_x1 = sp_auxlib::wrap_to_supermatrix(superX1, xx);
-				arma_wrapper(dgstrs)(options.Trans, L, U, perm_c, perm_r, &superX1, stat, info);
-				p_hat = xx;
-				// p_hat.print("p_hat");
-				sp_auxlib::destroy_supermatrix(superX1);
+				precond.solve(p_hat, p);
 
 				v = A * p_hat;
-				// v.print("v");
 				alpha = rho / dot(r_tld, v);
-				x = x + alpha * p_hat;
-				// x.print("x");
+				x += alpha * p_hat;
 				s = r - alpha * v;
-				// s.print("s");
 				*err = norm(s) / bnrm2;
 				if (*err < tol) {
+					*iter += 1;
 					break;
 				}
 
-				xx = s;
-				arma::superlu::SuperMatrix superX2;
-				arrayops::inplace_set(reinterpret_cast<char *>(&superX2), char(0), sizeof(arma::superlu::SuperMatrix));
-
-				const bool status_x2 = sp_auxlib::wrap_to_supermatrix(superX2, xx);
-				arma_wrapper(dgstrs)(options.Trans, L, U, perm_c, perm_r, &superX2, stat, info);
-				s_hat = xx;
-				sp_auxlib::destroy_supermatrix(superX2);
+				precond.solve(s_hat, s);
 
 				t = A * s_hat;
-				// t.print("t");
 				omega = dot(t, s) / dot(t, t);
-				x = x + omega * s_hat;
-				// x.print("x");
+				x += omega * s_hat;
 				r = s - omega * t;
-				// r.print("r");
 				*err = norm(r) / bnrm2;
 
 				if ((*err) <= tol) {
+					*iter += 1;
 					break;
 				}
 				if (omega == 0.0) {
@@ -428,19 +386,12 @@ namespace che {
 				}
 				rho_1 = rho;
 			}
-			// x.print("x_internal");
 
-			vec chk = b - A * x;
-			// chk.print("chk");
-
-			if ((*err) <= tol || all(s <= tol)) {
-				if (all(s <= tol)) {
-					*err = norm(s) / bnrm2;
-				}
+			if ((*err) <= tol) {
 				*flag = 0;
 			} else if (omega == 0.0) {
 				*flag = -2;
-			} else if (rho = 0.0) {
+			} else if (rho == 0.0) {
 				*flag = -1;
 			} else {
 				*flag = 1;
@@ -552,13 +503,57 @@ namespace che {
 
 		// }
 
+		/**
+		 * @brief Level-invariant data and workspaces of one PF stage.
+		 *
+		 * getCheSolution() fills the plan once before the level loop, so a level only accumulates the
+		 * right-hand side, solves with the stage factorization and updates the auxiliary series.
+		 */
+		struct ChePfStagePlan {
+			// coupling of the non-slack buses to the slack buses, Y(idxNonSw, isw)
+			sp_cx_mat YNonSwSw;
+			// ZIP loads: coefficients pre-divided by Bi0 and the constant rows of LHS_MatZip
+			vec JIb;
+			vec KIb;
+			vec invBi0;
+			vec Ji0Lb;
+			vec Ki0Lb;
+			cx_vec zipLhsC;
+			cx_vec zipLhsD;
+			// generators: constant factors of AG0 and BG0 in RHSIG1 and RHSIG2, pShare of the balancing machines
+			vec gen1A;
+			vec gen1B;
+			vec gen2A;
+			vec gen2B;
+			vec pShareBal;
+			// per-level workspaces
+			vec RHSILr;
+			vec RHSILi;
+			vec RHSIiLr;
+			vec RHSIiLi;
+			vec RHSIGr;
+			vec RHSIGi;
+			vec AG0;
+			vec BG0;
+			vec tempCD;
+			mat rhsBus;
+			mat rhsInd;
+			mat tempx;
+		};
+
 		CheSolution *ChePfCalculator::getCheSolution() {
 			int nlvl = compOpt.nLvl;
 
 			CheSingleEmbedSystem *embSys = cheList.back();
 			chedata::PsatDataSet baseSys(embSys->baseSys);
 			double sAlpha = embSys->startAlpha;
-			CheStateIdx stateIdx = embSys->initState.stateIdx;
+			// A warm start keeps every parameter but the injections and set-points at its full value (pAlpha) and
+			// drops their alpha derivative (dAlpha); the injections move from the base point to the set.
+			const ChePfEmbedSystem *pfSys = static_cast<const ChePfEmbedSystem *>(embSys);
+			bool warm = !pfSys->warmBase.state.is_empty();
+			double pAlpha = warm ? 1.0 : sAlpha;
+			double dAlpha = warm ? 0.0 : 1.0;
+			const CheStateIdx &stateIdx = *embSys->initState.stateIdx;
 			int nbus = baseSys.nBus;
 
 			// uvec islands = CheCompUtil::searchIslands(baseSys);
@@ -574,8 +569,8 @@ namespace che {
 			int npv = ipv.n_rows;
 			DEBUG_PRINT_MAT(busType)
 
-			sp_cx_mat Y = embSys->yMatrix.Ytr;
-			cx_vec Ysh = embSys->yMatrix.Ysh;
+			sp_cx_mat Y = embSys->yMatrix->Ytr;
+			cx_vec Ysh = embSys->yMatrix->Ysh;
 			cx_vec YshShunt(baseSys.get_shunts_g_vec(), baseSys.get_shunts_b_vec());
 			DEBUG_PRINT_MAT(YshShunt)
 
@@ -583,7 +578,7 @@ namespace che {
 			if (baseSys.nPl > 0) {
 				Ysh(C_IDX(baseSys.get_pls_busNumber_vec())) += cx_vec(baseSys.get_pls_g_vec(), baseSys.get_pls_b_vec());
 			}
-			Y.diag() += sAlpha * Ysh;
+			Y.diag() += pAlpha * Ysh;
 
 			vec pVec(baseSys.nBus, fill::zeros);
 			vec qVec(baseSys.nBus, fill::zeros);
@@ -601,29 +596,37 @@ namespace che {
 				qVec(C_IDX(baseSys.get_pls_busNumber_vec())) -= baseSys.get_pls_Q_vec() %
 																conv_to<vec>::from(baseSys.get_pls_status_vec());
 			}
-			vec pVec0 = sAlpha * pVec;
-			vec qVec0 = sAlpha * qVec;
+			const vec &pBase = pfSys->residualEval.pBase;
+			const vec &qBase = pfSys->residualEval.qBase;
+			vec pVec0 = pBase + sAlpha * (pVec - pBase);
+			vec qVec0 = qBase + sAlpha * (qVec - qBase);
+			cx_vec VBase(nbus, fill::ones);
+			if (warm) {
+				const CheStateIdx &baseIdx = *pfSys->warmBase.stateIdx;
+				VBase = cx_vec(pfSys->warmBase.getBlock(baseIdx.vrIdx), pfSys->warmBase.getBlock(baseIdx.viIdx));
+			}
+			vec VBaseSq = square(abs(VBase));
 			// qVec0(ipv) = embSys->initState.getSubVec(stateIdx.qIdx)(ipv);
 			vec VspSq2(nbus, fill::zeros);
-			VspSq2(ipv) = vMagVec(ipv) - 1;
-			VspSq2(isw) = vMagVec(isw) - 1;
+			VspSq2(ipv) = vMagVec(ipv) - VBaseSq(ipv);
+			VspSq2(isw) = vMagVec(isw) - VBaseSq(isw);
 
 			cx_mat V(nbus, nlvl + 1, fill::zeros);
-			cx_vec V0(embSys->initState.getSubVec(stateIdx.vrIdx), embSys->initState.getSubVec(stateIdx.viIdx));
+			cx_vec V0(embSys->initState.getBlock(stateIdx.vrIdx), embSys->initState.getBlock(stateIdx.viIdx));
 			V.col(0) = V0;
 			V(isw, uvec(1).fill(1)) = cx_vec(baseSys.get_sws_vMag_vec() % cos(datum::pi / 180.0 * baseSys.get_sws_vAng_vec()),
 											 baseSys.get_sws_vMag_vec() % sin(datum::pi / 180.0 * baseSys.get_sws_vAng_vec())) -
-									  1;
+									  VBase(isw);
 			cx_mat W(nbus, nlvl + 1, fill::zeros);
 			W.col(0) = 1 / V0;
 			mat P(nbus, nlvl + 1, fill::zeros);
 			P.col(0) = pVec0;
 			mat Q(nbus, nlvl + 1, fill::zeros);
 			mat Qxtra(nbus, nlvl + 1, fill::zeros);
-			Q.col(0) = embSys->initState.getSubVec(stateIdx.qIdx);
+			Q.col(0) = embSys->initState.getBlock(stateIdx.qIdx);
 			Qxtra.col(0) = qVec0;
-			P.col(1) = pVec;
-			Qxtra.col(1) = qVec;
+			P.col(1) = pVec - pBase;
+			Qxtra.col(1) = qVec - qBase;
 			// Q(find(busType != 0), regspace<uvec>(1, nlvl)).fill(0.);
 
 			vec C0 = real(V.col(0));
@@ -634,26 +637,12 @@ namespace che {
 			vec Qspec = Q.col(0) + Qxtra.col(0);
 			vec V0sq = C0 % C0 + D0 % D0;
 
-			sp_mat C0M(true, join_rows(regspace<uvec>(0, nbus - 1), regspace<uvec>(0, nbus - 1)).t(), C0, nbus, nbus);
-			sp_mat D0M(true, join_rows(regspace<uvec>(0, nbus - 1), regspace<uvec>(0, nbus - 1)).t(), D0, nbus, nbus);
-			sp_mat E0M(true, join_rows(regspace<uvec>(0, nbus - 1), regspace<uvec>(0, nbus - 1)).t(), E0, nbus, nbus);
-			sp_mat F0M(true, join_rows(regspace<uvec>(0, nbus - 1), regspace<uvec>(0, nbus - 1)).t(), F0, nbus, nbus);
-			sp_mat P0M(true, join_rows(regspace<uvec>(0, nbus - 1), regspace<uvec>(0, nbus - 1)).t(), Pspec, nbus, nbus);
-			sp_mat Q0M(true, join_rows(regspace<uvec>(0, nbus - 1), regspace<uvec>(0, nbus - 1)).t(), Qspec, nbus, nbus);
-
-			sp_mat G = real(Y);
-			sp_mat B = imag(Y);
-
 			DEBUG_PRINT_MAT(VspSq2)
-			DEBUG_PRINT_MAT(G)
-			DEBUG_PRINT_MAT(B)
-			DEBUG_PRINT_MAT(P0M)
-			DEBUG_PRINT_MAT(Q0M)
 
 			// Ind
 			int nInd = baseSys.nInd > 0 ? baseSys.nInd : 0;
 			uvec indIdx = C_IDX(baseSys.get_inds_busNumber_vec());
-			vec s0 = embSys->initState.getSubVec(stateIdx.sIdx);
+			vec s0 = embSys->initState.getBlock(stateIdx.sIdx);
 			mat s(nInd, nlvl + 1, fill::zeros);
 			s.col(0) = s0;
 			cx_mat IL(nInd, nlvl + 1, fill::zeros);
@@ -670,7 +659,7 @@ namespace che {
 			vec T2 = baseSys.get_inds_Tc_vec();
 
 			cx_vec Z1(R1, X1);
-			cx_vec Ym(0 / Xm, -sAlpha / Xm);
+			cx_vec Ym(0 / Xm, -pAlpha / Xm);
 			cx_vec cIndTemp = R2 % Ym + s0 % (Ym % cx_vec(0. * X2, X2) + 1);
 			IL.col(0) = V0(indIdx) % cIndTemp / (cx_vec(R2, s0 % X2) + Z1 % cIndTemp);
 			Vm.col(0) = V0(indIdx) - IL.col(0) % Z1;
@@ -681,8 +670,8 @@ namespace che {
 			vec JL0 = real(IL.col(0));
 			vec KL0 = imag(IL.col(0));
 
-			cx_vec Yeind0(0. / Xm, -sAlpha / Xm);
-			cx_vec Yeind1(0. / Xm, -1. / Xm);
+			cx_vec Yeind0(0. / Xm, -pAlpha / Xm);
+			cx_vec Yeind1(0. / Xm, -dAlpha / Xm);
 			cx_vec Ye1ind0 = Yeind0 % Z1;
 			cx_vec Ye1ind1 = Yeind1 % Z1;
 			vec Ge = real(Yeind0);
@@ -694,34 +683,55 @@ namespace che {
 			DEBUG_PRINT_MAT(kg1e)
 			DEBUG_PRINT_MAT(kb1e)
 
-			vector<mat> LHS_MatInd_Full;
-			vector<mat> RHS_C_Shr;
-			mat LHS_MatInd_Shr(nInd, 4, fill::zeros);
-			mat LHS_MatInd_Bus(nbus, 4, fill::zeros);
-
-			for (int i = 0; i < nInd; i++) {
-				mat LHS_MatInd(5, 7);
-				LHS_MatInd << R2(i) << -X2(i) * s0(i) << R1(i) * s0(i) << -X1(i) * s0(i) << -K0(i) * X2(i) - C0(indIdx(i)) + JL0(i) * R1(i) - KL0(i) * X1(i) << -s0(i) << 0.0 << endr
-						   << X2(i) * s0(i) << R2(i) << X1(i) * s0(i) << R1(i) * s0(i) << J0(i) * X2(i) - D0(indIdx(i)) + JL0(i) * X1(i) + KL0(i) * R1(i) << 0.0 << -s0(i) << endr
-						   << C0(indIdx(i)) - JL0(i) * R1(i) + KL0(i) * X1(i) << D0(indIdx(i)) - KL0(i) * R1(i) - JL0(i) * X1(i) << -J0(i) * R1(i) - K0(i) * X1(i) << -K0(i) * R1(i) + J0(i) * X1(i) << -sAlpha * (T1(i) + 2. * T2(i) * s0(i)) << J0(i) << K0(i) << endr
-						   << -1. << 0. << 1. + kg1e(i) << -kb1e(i) << 0. << -Ge(i) << Be(i) << endr
-						   << 0. << -1. << kb1e(i) << 1. + kg1e(i) << 0. << -Be(i) << -Ge(i) << endr;
-				mat MatIndA = LHS_MatInd(span::all, span(0, 4));
-				mat MatIndB = LHS_MatInd(span::all, span(5, 6));
-				mat MatInvA = inv(MatIndA);
-				mat MadCDtoRest = -MatInvA * MatIndB;
-
-				DEBUG_PRINT_MAT(LHS_MatInd)
-				DEBUG_PRINT_MAT(MatIndA)
-				DEBUG_PRINT_MAT(MatIndB)
-				DEBUG_PRINT_MAT(MatInvA)
-				DEBUG_PRINT_MAT(MadCDtoRest)
-
-				RHS_C_Shr.push_back(MatInvA);
-				LHS_MatInd_Full.push_back(MadCDtoRest);
-				LHS_MatInd_Shr.row(i) = MadCDtoRest.rows(span(2, 3)).as_row();
+			// 5x7 motor blocks [A B] packed per CheSmallMatKernel, column r + c * 5 holds entry (r, c)
+			vec C0ind = C0(indIdx);
+			vec D0ind = D0(indIdx);
+			mat MatIndA(nInd, 25, fill::zeros);
+			mat MatIndB(nInd, 10, fill::zeros);
+			MatIndA.col(0) = R2;
+			MatIndA.col(5) = -X2 % s0;
+			MatIndA.col(10) = R1 % s0;
+			MatIndA.col(15) = -X1 % s0;
+			MatIndA.col(20) = -K0 % X2 - C0ind + JL0 % R1 - KL0 % X1;
+			MatIndB.col(0) = -s0;
+			MatIndA.col(1) = X2 % s0;
+			MatIndA.col(6) = R2;
+			MatIndA.col(11) = X1 % s0;
+			MatIndA.col(16) = R1 % s0;
+			MatIndA.col(21) = J0 % X2 - D0ind + JL0 % X1 + KL0 % R1;
+			MatIndB.col(6) = -s0;
+			MatIndA.col(2) = C0ind - JL0 % R1 + KL0 % X1;
+			MatIndA.col(7) = D0ind - KL0 % R1 - JL0 % X1;
+			MatIndA.col(12) = -J0 % R1 - K0 % X1;
+			MatIndA.col(17) = -K0 % R1 + J0 % X1;
+			MatIndA.col(22) = -pAlpha * (T1 + 2. * T2 % s0);
+			MatIndB.col(2) = J0;
+			MatIndB.col(7) = K0;
+			MatIndA.col(3).fill(-1.);
+			MatIndA.col(13) = 1. + kg1e;
+			MatIndA.col(18) = -kb1e;
+			MatIndB.col(3) = -Ge;
+			MatIndB.col(8) = Be;
+			MatIndA.col(9).fill(-1.);
+			MatIndA.col(14) = kb1e;
+			MatIndA.col(19) = 1. + kg1e;
+			MatIndB.col(4) = -Be;
+			MatIndB.col(9) = -Ge;
+
+			mat RHS_C_Shr;
+			if (CheSmallMatKernel::inv<5>(MatIndA, RHS_C_Shr) > 0) {
+				throw std::runtime_error("inv(): induction motor block is singular");
 			}
+			mat LHS_MatInd_Full;
+			CheSmallMatKernel::mul<5, 5, 2>(RHS_C_Shr, MatIndB, LHS_MatInd_Full);
+			LHS_MatInd_Full = -LHS_MatInd_Full;
+			mat LHS_MatInd_Shr = LHS_MatInd_Full.cols(uvec({2, 7, 3, 8}));
+			mat LHS_MatInd_Bus(nbus, 4, fill::zeros);
 			LHS_MatInd_Bus.rows(indIdx) += LHS_MatInd_Shr;
+			DEBUG_PRINT_MAT(MatIndA)
+			DEBUG_PRINT_MAT(MatIndB)
+			DEBUG_PRINT_MAT(RHS_C_Shr)
+			DEBUG_PRINT_MAT(LHS_MatInd_Full)
 
 			DEBUG_PRINT_MAT(J0)
 			DEBUG_PRINT_MAT(K0)
@@ -738,7 +748,7 @@ namespace che {
 			vec Bi0 = abs(V0(zipIdx));
 			vec JI = baseSys.get_pls_Ip_vec();
 			vec KI = -baseSys.get_pls_Iq_vec();
-			cx_vec Ii0L = sAlpha * cx_vec(JI, KI) % V0(zipIdx) / Bi0;
+			cx_vec Ii0L = pAlpha * cx_vec(JI, KI) % V0(zipIdx) / Bi0;
 			vec Ji0L = real(Ii0L);
 			vec Ki0L = imag(Ii0L);
 
@@ -746,10 +756,10 @@ namespace che {
 			BiL.col(0) = Bi0;
 			vec Ci0 = real(V0(zipIdx));
 			vec Di0 = imag(V0(zipIdx));
-			mat LHS_MatZip = join_rows(sAlpha * JI / Bi0 - Ci0 % Ji0L / Bi0 / Bi0,
-									   -sAlpha * KI / Bi0 - Di0 % Ji0L / Bi0 / Bi0,
-									   sAlpha * KI / Bi0 - Ci0 % Ki0L / Bi0 / Bi0,
-									   sAlpha * JI / Bi0 - Di0 % Ki0L / Bi0 / Bi0);
+			mat LHS_MatZip = join_rows(pAlpha * JI / Bi0 - Ci0 % Ji0L / Bi0 / Bi0,
+									   -pAlpha * KI / Bi0 - Di0 % Ji0L / Bi0 / Bi0,
+									   pAlpha * KI / Bi0 - Ci0 % Ki0L / Bi0 / Bi0,
+									   pAlpha * JI / Bi0 - Di0 % Ki0L / Bi0 / Bi0);
 			mat Mat_BZip = join_rows(Ci0 / Bi0, Di0 / Bi0);
 
 			DEBUG_PRINT_MAT(Bi0)
@@ -772,8 +782,8 @@ namespace che {
 			mat Cd(nSyn, nlvl + 1, fill::zeros);
 			mat Sd(nSyn, nlvl + 1, fill::zeros);
 			mat Ef(nSyn, nlvl + 1, fill::zeros);
-			vec d0 = embSys->initState.getSubVec(stateIdx.mDeltaIdx);
-			vec Ef0 = embSys->initState.getSubVec(stateIdx.mEfIdx);
+			vec d0 = embSys->initState.getBlock(stateIdx.mDeltaIdx);
+			vec Ef0 = embSys->initState.getBlock(stateIdx.mEfIdx);
 			vec Efd = 0.0 * Ef0;
 			vec Efq = Ef0;
 			vec cosd = cos(d0);
@@ -792,6 +802,10 @@ namespace che {
 			Sd.col(0) = sind;
 			Ef.col(0) = Ef0;
 			Ef.col(1) = this->paraEf - 1;
+			if (warm) {
+				const CheStateIdx &baseIdx = *pfSys->warmBase.stateIdx;
+				Ef.col(1) += 1 - pfSys->warmBase.getBlock(baseIdx.mEfIdx);
+			}
 			vec CG0 = Cg;
 			vec DG0 = Dg;
 			vec JG0 = JG.col(0);
@@ -801,6 +815,10 @@ namespace che {
 			mat Pm(nSyn, nlvl + 1, fill::zeros);
 			Pm.col(0) = Efq % Iq + Efd % Id;
 			Pm.col(1) = paraPm;
+			if (warm) {
+				const CheStateIdx &baseIdx = *pfSys->warmBase.stateIdx;
+				Pm.col(1) -= pfSys->warmBase.getBlock(baseIdx.mPgIdx);
+			}
 			DEBUG_PRINT_MAT(paraPm)
 			DEBUG_PRINT_MAT(this->paraEf)
 			DEBUG_PRINT_MAT(Rs)
@@ -829,6 +847,7 @@ namespace che {
 			int nTaylor = 4; // Will be moved to a simulation setting structure
 			mat cosp = getTaylorPolynomialsCos(d0, nTaylor);
 			mat sinp = getTaylorPolynomialsSin(d0, nTaylor);
+			shared_ptr<const CheConvolutionPlan> convPlan = CheConvolutionPlan::getPlan(nlvl, nTaylor);
 
 			vec A1n(nSyn, fill::zeros);
 			vec B1n(nSyn, fill::zeros);
@@ -898,11 +917,38 @@ namespace che {
 									 join_rows(MatG2C, MatG2D), join_rows(MatG5AC, MatG5AD));
 			sp_mat MatGB = join_cols(join_rows(MatG1J, MatG1K, MatG1d),
 									 join_rows(MatG2J, MatG2K, MatG2d), join_rows(MatG5AJ, MatG5AK, MatG5Ad));
-			sp_mat MatGBiA(-spsolve(MatGB, mat(MatGA)));
+			// MatGB is constant over the stage: factor it once and reuse it for MatGBiA and every level. MatGA
+			// only has entries in the columns of the generator buses, so only those columns are solved for.
+			if (this->genSolver == NULL) {
+				this->genSolver = CheSparseSolverFactory::makeSolver(CHESPSOLVER_SUPERLU, 1);
+			}
+			sp_mat MatGBiA(3 * nSyn, 2 * nbus);
+			uvec gaCols;
+			sp_mat gaSel;
+			mat GBiAcols;
+			if (nSyn > 0) {
+				bool factOk = this->genSolver->isFactored() ? this->genSolver->refactor(MatGB) : this->genSolver->factor(MatGB);
+				if (!factOk) {
+					cerr << logTag << "Factorization of MatGB failed." << endl;
+					return NULL;
+				}
+				gaCols = unique(join_cols(synIdx, synIdx + nbus));
+				gaSel = sp_mat(true, join_rows(gaCols, regspace<uvec>(0, gaCols.n_rows - 1)).t(),
+							   vec(gaCols.n_rows, fill::ones), 2 * nbus, gaCols.n_rows);
+				if (!this->genSolver->solve(GBiAcols, mat(MatGA * gaSel))) {
+					cerr << logTag << "Solve with MatGB failed." << endl;
+					return NULL;
+				}
+				MatGBiA = -sp_mat(GBiAcols) * gaSel.t();
+			}
 			sp_mat GTrMat(true, join_rows(synIdx, synRegIdx).t(), vec(nSyn, fill::ones), nbus, nSyn);
 			sp_mat MatGTrans = join_cols(join_rows(GTrMat, sp_mat(nbus, nSyn), sp_mat(nbus, nSyn)),
 										 join_rows(sp_mat(nbus, nSyn), GTrMat, sp_mat(nbus, nSyn)));
-			sp_mat MatGCD = MatGTrans * MatGBiA;
+			// MatGTrans * MatGBiA only has entries in the rows and columns gaCols of the stacked bus voltages.
+			mat genLhs;
+			if (nSyn > 0) {
+				genLhs = -(sp_mat(gaSel.t() * MatGTrans) * GBiAcols);
+			}
 
 			DEBUG_PRINT_MAT(pSharex)
 			DEBUG_PRINT_MAT(MatG1C)
@@ -929,166 +975,112 @@ namespace che {
 			DEBUG_PRINT_MAT(MatGB)
 			DEBUG_PRINT_MAT(GTrMat)
 			DEBUG_PRINT_MAT(MatGTrans)
-			DEBUG_PRINT_MAT(MatGCD)
-
-			sp_mat Y11 = -G;
-			sp_mat Y12 = B;
-			sp_mat Y21 = -B;
-			sp_mat Y22 = -G;
-
-			sp_mat YEF11 = P0M;
-			sp_mat YEF12 = -Q0M;
-			sp_mat YEF21 = -Q0M;
-			sp_mat YEF22 = -P0M;
-
-			vec auxDiag0(nbus, fill::zeros);
-			auxDiag0(zipIdx) += LHS_MatZip.col(0);
-			Y11.diag() -= auxDiag0 + LHS_MatInd_Bus.col(0);
-			auxDiag0.fill(0);
-			auxDiag0(zipIdx) += LHS_MatZip.col(1);
-			Y12.diag() -= auxDiag0 + LHS_MatInd_Bus.col(1);
-			auxDiag0.fill(0);
-			auxDiag0(zipIdx) += LHS_MatZip.col(2);
-			Y21.diag() -= auxDiag0 + LHS_MatInd_Bus.col(2);
-			auxDiag0.fill(0);
-			auxDiag0(zipIdx) += LHS_MatZip.col(3);
-			Y22.diag() -= auxDiag0 + LHS_MatInd_Bus.col(3);
+			DEBUG_PRINT_MAT(genLhs)
+
+			// Diagonal terms of the four voltage blocks: ZIP loads, induction motors and the constant power injections.
+			mat lhsDiag(nbus, 4, fill::zeros);
+			lhsDiag.rows(zipIdx) -= LHS_MatZip;
+			lhsDiag -= LHS_MatInd_Bus;
 
 			vec C0i = C0 / V0sq;
 			vec D0i = D0 / V0sq;
 			vec PCQD = Pspec % C0i + Qspec % D0i;
 			vec PDQC = Pspec % D0i - Qspec % C0i;
-			Y11.diag() -= PCQD % E0 + PDQC % F0;
-			Y12.diag() -= -PCQD % F0 + PDQC % E0;
-			Y21.diag() -= PDQC % E0 - PCQD % F0;
-			Y22.diag() -= -PDQC % F0 - PCQD % E0;
+			lhsDiag.col(0) -= PCQD % E0 + PDQC % F0;
+			lhsDiag.col(1) -= -PCQD % F0 + PDQC % E0;
+			lhsDiag.col(2) -= PDQC % E0 - PCQD % F0;
+			lhsDiag.col(3) -= -PDQC % F0 - PCQD % E0;
 
-			sp_mat YLHS = join_cols(join_rows(Y11, Y12), join_rows(Y21, Y22));
+			uvec idxNonSw = find(busType != 2);
+
+			// A PV bus held at a Q limit behaves as a PQ bus: its voltage row becomes dQ = 0.
+			uvec ipvClamped;
+			if (!pfSys->qClamp.is_empty()) {
+				vec qClampPv = pfSys->qClamp(ipv);
+				ipvClamped = find_finite(qClampPv);
+			}
 
-			YLHS += MatGCD;
+			// LHS_mat = [YLHS(nonSw, nonSw) + MatGTrans * MatGBiA, -[F0; E0](nonSw, pv); [C0 D0](pv, nonSw), 0],
+			// written into a pattern that is kept for the whole network.
+			const sp_mat &LHS_mat = lhsAssembler.assemble(Y, C_IDX(baseSys.get_lines_fromBus_vec()), C_IDX(baseSys.get_lines_toBus_vec()),
+														  busType, lhsDiag, gaCols, genLhs, C0, D0, E0, F0, ipvClamped);
 
-			uvec idxNonSw = find(busType != 2);
-			uvec idxStackMat = join_cols(idxNonSw, idxNonSw + nbus);
-
-			sp_mat YLHSx = CheCompUtil::sp_submatrix<double>(YLHS, idxStackMat, idxStackMat);
-
-			/*sp_mat YEFx = join_cols(
-				join_rows(
-					CheCompUtil::sp_submatrix<double>(YEF11, idxNonSw, idxNonSw),
-					CheCompUtil::sp_submatrix<double>(YEF12, idxNonSw, idxNonSw),
-					-CheCompUtil::sp_submatrix<double>(F0M, idxNonSw, ipv)),
-				join_rows(
-					CheCompUtil::sp_submatrix<double>(YEF21, idxNonSw, idxNonSw),
-					CheCompUtil::sp_submatrix<double>(YEF22, idxNonSw, idxNonSw),
-					-CheCompUtil::sp_submatrix<double>(E0M, idxNonSw, ipv)));
-			sp_mat YCDx = join_rows(
-				CheCompUtil::sp_submatrix<double>(C0M, ipv, idxNonSw),
-				CheCompUtil::sp_submatrix<double>(D0M, ipv, idxNonSw),
-				sp_mat(npv, 2 * npq + 3 * npv));
-			sp_mat CM = CheCompUtil::sp_submatrix<double>(C0M, idxNonSw, idxNonSw);
-			sp_mat DM = CheCompUtil::sp_submatrix<double>(D0M, idxNonSw, idxNonSw);
-			sp_mat EM = CheCompUtil::sp_submatrix<double>(E0M, idxNonSw, idxNonSw);
-			sp_mat FM = CheCompUtil::sp_submatrix<double>(F0M, idxNonSw, idxNonSw);
-			sp_mat EFMx = join_cols(join_rows(EM, -FM), join_rows(FM, EM));
-			sp_mat CDMx = join_cols(join_rows(CM, -DM), join_rows(DM, CM));*/
-
-			sp_mat YEFx = join_cols(-CheCompUtil::sp_submatrix<double>(F0M, idxNonSw, ipv), -CheCompUtil::sp_submatrix<double>(E0M, idxNonSw, ipv));
-			sp_mat YCDx = join_rows(
-				CheCompUtil::sp_submatrix<double>(C0M, ipv, idxNonSw),
-				CheCompUtil::sp_submatrix<double>(D0M, ipv, idxNonSw),
-				sp_mat(npv, npv));
-
-			sp_mat LHS_mat = join_cols(
-				join_rows(YLHSx, YEFx),
-				YCDx);
-
-			// superlu settings
-			superlu_opts superlu_opts_default;
-			arma::superlu::superlu_options_t options;
-			sp_auxlib::set_superlu_opts(options, superlu_opts_default);
-			options.IterRefine = arma::superlu::NOREFINE;
-			options.RefineInitialized = arma::superlu::NO;
-
-			const sp_mat &A = LHS_mat;
-
-			arma::superlu::SuperMatrix superX;
-			arrayops::inplace_set(reinterpret_cast<char *>(&superX), char(0), sizeof(arma::superlu::SuperMatrix));
-			arma::superlu::SuperMatrix superA;
-			arrayops::inplace_set(reinterpret_cast<char *>(&superA), char(0), sizeof(arma::superlu::SuperMatrix));
-			arma::superlu::SuperMatrix superB;
-			arrayops::inplace_set(reinterpret_cast<char *>(&superB), char(0), sizeof(arma::superlu::SuperMatrix));
-			const bool status_a = sp_auxlib::copy_to_supermatrix(superA, A);
-			arma::superlu::SuperMatrix superL;
-			arrayops::inplace_set(reinterpret_cast<char *>(&superL), char(0), sizeof(arma::superlu::SuperMatrix));
-			arma::superlu::SuperMatrix superU;
-			arrayops::inplace_set(reinterpret_cast<char *>(&superU), char(0), sizeof(arma::superlu::SuperMatrix));
-
-			int *perm_c = (int *)arma::superlu::malloc((A.n_cols + 1) * sizeof(int));
-			int *perm_r = (int *)arma::superlu::malloc((A.n_rows + 1) * sizeof(int));
-			int *etree = (int *)arma::superlu::malloc((A.n_cols + 1) * sizeof(int));
-			double *R = (double *)arma::superlu::malloc((A.n_rows + 1) * sizeof(double));
-			double *C = (double *)arma::superlu::malloc((A.n_cols + 1) * sizeof(double));
-			double *ferr = (double *)arma::superlu::malloc((1 + 1) * sizeof(double));
-			double *berr = (double *)arma::superlu::malloc((1 + 1) * sizeof(double));
-			arrayops::inplace_set(perm_c, 0, A.n_cols + 1);
-			arrayops::inplace_set(perm_r, 0, A.n_rows + 1);
-			arrayops::inplace_set(etree, 0, A.n_cols + 1);
-
-			arrayops::inplace_set(R, double(0), A.n_rows + 1);
-			arrayops::inplace_set(C, double(0), A.n_cols + 1);
-			arrayops::inplace_set(ferr, double(0), 1 + 1);
-			arrayops::inplace_set(berr, double(0), 1 + 1);
-
-			arma::superlu::GlobalLU_t glu;
-			arrayops::inplace_set(reinterpret_cast<char *>(&glu), char(0), sizeof(arma::superlu::GlobalLU_t));
-
-			arma::superlu::mem_usage_t mu;
-			arrayops::inplace_set(reinterpret_cast<char *>(&mu), char(0), sizeof(arma::superlu::mem_usage_t));
-
-			arma::superlu::SuperLUStat_t stat;
-			arma::superlu::init_stat(&stat);
-
-			char equed[8]; // extra characters for paranoia
-			double rpg = double(0);
-			double rcond = double(0);
-			int superInfo = 0; // Return code.
-
-			char work[8];
-			int lwork = int(0); // 0 means superlu will allocate memory
+			if (this->linSolver == NULL) {
+				this->linSolver = CheSparseSolverFactory::makeSolver(this->solverType, this->nSolverThreads);
+			}
 
+			// Workspaces of the fused Cauchy-product kernels, kept alive across levels so that the
+			// per-level convolutions do not allocate.
+			cx_vec convVmS, convIRS, convVIR, convILIR, convVV, convIB, convVCd, convVSd, convCx;
+			vec convSSm, convSSR, convBB, convJC, convKC, convJS, convKS, convVJK, convJJ, convKK;
+			const cx_vec jX2m = cx_vec(0.0 * X2, -X2);
+
+			bool staleLu = false;
+			int stageIter = 0;
+
+			ChePfStagePlan plan;
+			plan.YNonSwSw = CheCompUtil::sp_submatrix<cx_double>(Y, idxNonSw, isw);
+			plan.invBi0 = 1.0 / Bi0;
+			plan.JIb = dAlpha * JI % plan.invBi0;
+			plan.KIb = dAlpha * KI % plan.invBi0;
+			plan.Ji0Lb = Ji0L % plan.invBi0;
+			plan.Ki0Lb = Ki0L % plan.invBi0;
+			plan.zipLhsC = cx_vec(LHS_MatZip.col(0), LHS_MatZip.col(2));
+			plan.zipLhsD = cx_vec(LHS_MatZip.col(1), LHS_MatZip.col(3));
+			plan.gen1A = CG0 + Rs % JG0 - Xd % KG0;
+			plan.gen1B = DG0 + Rs % KG0 + Xd % JG0;
+			plan.gen2A = -DG0 - Rs % KG0 - Xq % JG0;
+			plan.gen2B = CG0 + Rs % JG0 - Xq % KG0;
+			plan.pShareBal = pShare(idxBalSyn);
+			plan.RHSILr.set_size(nbus);
+			plan.RHSILi.set_size(nbus);
+			plan.RHSIiLr.set_size(nbus);
+			plan.RHSIiLi.set_size(nbus);
+			plan.RHSIGr.set_size(nbus);
+			plan.RHSIGi.set_size(nbus);
+			plan.AG0.set_size(nSyn);
+			plan.BG0.set_size(nSyn);
+			plan.rhsBus.set_size(nInd, 5);
+			plan.rhsInd.set_size(nInd, 5);
+
+			pctimer_t levelStart = pctimer();
 			DEBUG_PRINT_MAT(LHS_mat)
 			// LOOP Body
 			for (int lvl = 0; lvl < nlvl; lvl++) {
-				umat seq2 = CheCompUtil::spgetseq(lvl + 1, 2);
-				umat seq2p = CheCompUtil::spgetseq(lvl + 2, 2);
-				umat seq2m = CheCompUtil::spgetseq(lvl, 2);
-				umat seq3 = CheCompUtil::spgetseq(lvl + 1, 3);
-				uvec idxSeq2 = any(seq2 == lvl + 1, 1);
-				uvec idxSeq3 = any(seq3 == lvl + 1, 1);
-				umat seq2R = seq2.rows(find(idxSeq2 == 0));
-				umat seq3R = seq3.rows(find(idxSeq3 == 0));
-
-				vec RHSILr(nbus, fill::zeros);
-				vec RHSILi(nbus, fill::zeros);
+				const umat &seq2 = convPlan->seq2[lvl];
+				const umat &seq2m = convPlan->seq2m[lvl];
+				const umat &seq2R = convPlan->seq2R[lvl];
+				const umat &seq3R = convPlan->seq3R[lvl];
+
+				plan.RHSILr.zeros();
+				vec &RHSILr = plan.RHSILr;
+				plan.RHSILi.zeros();
+				vec &RHSILi = plan.RHSILi;
 
 				// LOOP-Ind
-				mat rhsBus(nInd, 5, fill::zeros);
-				cx_vec rhsM = sum(Vm.cols(seq2R.col(0)) % s.cols(seq2R.col(1)), 1) +
-							  cx_vec(0.0 * X2, -X2) % sum(IR.cols(seq2R.col(0)) % s.cols(seq2R.col(1)), 1);
-				vec rhsImod = T1 % s.col(lvl) +
-							  T2 % sum(s.cols(seq2m.col(0)) % s.cols(seq2m.col(1)), 1) +
-							  sAlpha * T2 % sum(s.cols(seq2R.col(0)) % s.cols(seq2R.col(1)), 1) -
-							  real(sum(V(indIdx, seq2R.col(0)) % conj(IR.cols(seq2R.col(1))), 1)) +
-							  real(sum(IL.cols(seq2R.col(0)) % conj(IR.cols(seq2R.col(1))), 1) % Z1);
+				mat &rhsBus = plan.rhsBus;
+				CheConvKernel::cauchyCR(Vm, s, seq2R, convVmS);
+				CheConvKernel::cauchyCR(IR, s, seq2R, convIRS);
+				CheConvKernel::cauchyRR(s, s, seq2m, convSSm);
+				CheConvKernel::cauchyRR(s, s, seq2R, convSSR);
+				CheConvKernel::cauchyCConjRows(V, indIdx, IR, seq2R, convVIR);
+				CheConvKernel::cauchyCConj(IL, IR, seq2R, convILIR);
+				cx_vec rhsM = convVmS + jX2m % convIRS;
+				vec rhsImod = dAlpha * (T1 % s.col(lvl) + T2 % convSSm) +
+							  pAlpha * T2 % convSSR -
+							  real(convVIR) +
+							  real(convILIR % Z1);
 				if (lvl == 0)
-					rhsImod += T0;
+					rhsImod += dAlpha * T0;
 				cx_vec rhsIL = V(indIdx, uvec(1).fill(lvl)).as_col() % Yeind1 -
 							   IL.col(lvl) % Ye1ind1;
-				for (int i = 0; i < nInd; i++) {
-					vec tempRhsInd(5);
-					tempRhsInd << real(rhsM(i)) << imag(rhsM(i)) << rhsImod(i) << real(rhsIL(i)) << imag(rhsIL(i));
-					rhsBus.row(i) = (RHS_C_Shr[i] * tempRhsInd).t();
-				}
+				mat &rhsInd = plan.rhsInd;
+				rhsInd.col(0) = real(rhsM);
+				rhsInd.col(1) = imag(rhsM);
+				rhsInd.col(2) = rhsImod;
+				rhsInd.col(3) = real(rhsIL);
+				rhsInd.col(4) = imag(rhsIL);
+				CheSmallMatKernel::mul<5, 5, 1>(RHS_C_Shr, rhsInd, rhsBus);
 				RHSILr(indIdx) += rhsBus.col(2);
 				RHSILi(indIdx) += rhsBus.col(3);
 				// DEBUG_PRINT_MAT(RHSILr)
@@ -1098,17 +1090,23 @@ namespace che {
 				DEBUG_PRINT_MAT(RHSILi)	 // TODO: DEBUG this
 
 				// LOOP-Zip
-				vec RHSIiLr(nbus, fill::zeros);
-				vec RHSIiLi(nbus, fill::zeros);
-
-				vec RHS_BZip = (real(sum(V(zipIdx, seq2R.col(0)) % conj(V(zipIdx, seq2R.col(1))), 1)) -
-								sum(BiL.cols(seq2R.col(0)) % BiL.cols(seq2R.col(1)), 1)) /
-							   Bi0 / 2.0;
-				cx_vec RHZ_BIConv = sum(IiL.cols(seq2R.col(0)) % BiL.cols(seq2R.col(1)), 1);
-				vec RHSIiLr_full = (JI % real(V(zipIdx, uvec(1).fill(lvl)).as_col()) - KI % imag(V(zipIdx, uvec(1).fill(lvl)).as_col())) / Bi0 -
-								   real(RHZ_BIConv) / Bi0 - Ji0L % RHS_BZip / Bi0;
-				vec RHSIiLi_full = (KI % real(V(zipIdx, uvec(1).fill(lvl)).as_col()) + JI % imag(V(zipIdx, uvec(1).fill(lvl)).as_col())) / Bi0 -
-								   imag(RHZ_BIConv) / Bi0 - Ki0L % RHS_BZip / Bi0;
+				plan.RHSIiLr.zeros();
+				vec &RHSIiLr = plan.RHSIiLr;
+				plan.RHSIiLi.zeros();
+				vec &RHSIiLi = plan.RHSIiLi;
+
+				CheConvKernel::cauchyCConjRows(V, zipIdx, V, zipIdx, seq2R, convVV);
+				CheConvKernel::cauchyRR(BiL, BiL, seq2R, convBB);
+				CheConvKernel::cauchyCR(IiL, BiL, seq2R, convIB);
+				vec RHS_BZip = 0.5 * (real(convVV) - convBB) % plan.invBi0;
+				const cx_vec &RHZ_BIConv = convIB;
+				cx_vec Vzip = V(zipIdx, uvec(1).fill(lvl)).as_col();
+				vec VzipR = real(Vzip);
+				vec VzipI = imag(Vzip);
+				vec RHSIiLr_full = plan.JIb % VzipR - plan.KIb % VzipI -
+								   real(RHZ_BIConv) % plan.invBi0 - plan.Ji0Lb % RHS_BZip;
+				vec RHSIiLi_full = plan.KIb % VzipR + plan.JIb % VzipI -
+								   imag(RHZ_BIConv) % plan.invBi0 - plan.Ki0Lb % RHS_BZip;
 				RHSIiLr(zipIdx) += RHSIiLr_full;
 				RHSIiLi(zipIdx) += RHSIiLi_full;
 				DEBUG_PRINT_MAT(RHS_BZip)
@@ -1118,53 +1116,61 @@ namespace che {
 				DEBUG_PRINT_MAT(RHSIiLi_full)
 
 				// LOOP-Syn
-				vec RHSIGr(nbus, fill::zeros);
-				vec RHSIGi(nbus, fill::zeros);
-
-				vec AG0(nSyn, fill::zeros);
-				vec BG0(nSyn, fill::zeros);
-				vec tempCD(nSyn, fill::zeros);
+				vec &RHSIGr = plan.RHSIGr;
+				vec &RHSIGi = plan.RHSIGi;
+
+				plan.AG0.zeros();
+				vec &AG0 = plan.AG0;
+				plan.BG0.zeros();
+				vec &BG0 = plan.BG0;
+				vec &tempCD = plan.tempCD;
 				if (nTaylor >= 2) {
-					tempCD = sum(d.cols(seq2R.col(0)) % d.cols(seq2R.col(1)), 1);
+					CheConvKernel::cauchyRR(d, d, seq2R, tempCD);
 					AG0 += cosp.col(2) % tempCD;
 					BG0 += sinp.col(2) % tempCD;
 				}
 				if (nTaylor >= 3) {
-					tempCD = sum(d.cols(seq3R.col(0)) % d.cols(seq3R.col(1)) % d.cols(seq3R.col(2)), 1);
+					CheConvKernel::cauchyRRR(d, d, d, seq3R, tempCD);
 					AG0 += cosp.col(3) % tempCD;
 					BG0 += sinp.col(3) % tempCD;
 				}
 				if (nTaylor >= 4) {
-					umat seq4 = CheCompUtil::spgetseq(lvl + 1, 4);
-					uvec idxSeq4 = any(seq4 == lvl + 1, 1);
-					umat seq4R = seq4.rows(find(idxSeq4 == 0));
-
-					tempCD = sum(d.cols(seq4R.col(0)) % d.cols(seq4R.col(1)) % d.cols(seq4R.col(2)) % d.cols(seq4R.col(3)), 1);
+					const umat &seq4R = convPlan->seq4R[lvl];
+					CheConvKernel::cauchyRRRR(d, d, d, d, seq4R, tempCD);
 					AG0 += cosp.col(4) % tempCD;
 					BG0 += sinp.col(4) % tempCD;
 				}
 
-				vec CCr = sum(real(V(synIdx, seq2R.col(0))) % Cd.cols(seq2R.col(1)), 1);
-				vec DCr = sum(imag(V(synIdx, seq2R.col(0))) % Cd.cols(seq2R.col(1)), 1);
-				vec CSr = sum(real(V(synIdx, seq2R.col(0))) % Sd.cols(seq2R.col(1)), 1);
-				vec DSr = sum(imag(V(synIdx, seq2R.col(0))) % Sd.cols(seq2R.col(1)), 1);
-				vec JCr = sum(JG.cols(seq2R.col(0)) % Cd.cols(seq2R.col(1)), 1);
-				vec KCr = sum(KG.cols(seq2R.col(0)) % Cd.cols(seq2R.col(1)), 1);
-				vec JSr = sum(JG.cols(seq2R.col(0)) % Sd.cols(seq2R.col(1)), 1);
-				vec KSr = sum(KG.cols(seq2R.col(0)) % Sd.cols(seq2R.col(1)), 1);
+				CheConvKernel::cauchyCRRows(V, synIdx, Cd, seq2R, convVCd);
+				CheConvKernel::cauchyCRRows(V, synIdx, Sd, seq2R, convVSd);
+				CheConvKernel::cauchyRR(JG, Cd, seq2R, convJC);
+				CheConvKernel::cauchyRR(KG, Cd, seq2R, convKC);
+				CheConvKernel::cauchyRR(JG, Sd, seq2R, convJS);
+				CheConvKernel::cauchyRR(KG, Sd, seq2R, convKS);
+				vec CCr = real(convVCd);
+				vec DCr = imag(convVCd);
+				vec CSr = real(convVSd);
+				vec DSr = imag(convVSd);
+				const vec &JCr = convJC;
+				const vec &KCr = convKC;
+				const vec &JSr = convJS;
+				const vec &KSr = convKS;
 
 				vec RHSIG1 = Ef.col(lvl + 1) - (CCr + DSr + Rs % (JCr + KSr) + Xd % (JSr - KCr)) -
-							 (CG0 + Rs % JG0 - Xd % KG0) % AG0 - (DG0 + Rs % KG0 + Xd % JG0) % BG0;
+							 plan.gen1A % AG0 - plan.gen1B % BG0;
 				vec RHSIG2 = -(CSr - DCr + Rs % (JSr - KCr) - Xq % (JCr + KSr)) -
-							 (-DG0 - Rs % KG0 - Xq % JG0) % AG0 - (CG0 + Rs % JG0 - Xq % KG0) % BG0;
-				vec RHSIG3temp = -Pm.col(lvl + 1) +
-								 sum(real(V(synIdx, seq2R.col(0)) % cx_mat(JG.cols(seq2R.col(1)), -KG.cols(seq2R.col(1)))), 1) +
-								 (sum(JG.cols(seq2R.col(0)) % JG.cols(seq2R.col(1)), 1) +
-								  sum(KG.cols(seq2R.col(0)) % KG.cols(seq2R.col(1)), 1)) %
-									 Rs;
-				vec RHSIG3 = pShare(idxBalSyn) % RHSIG3temp - RHSIG3temp(idxBalSyn) % pShare;
+							 plan.gen2A % AG0 - plan.gen2B % BG0;
+				CheConvKernel::cauchyReCConjSplitRows(V, synIdx, JG, KG, seq2R, convVJK);
+				CheConvKernel::cauchyRR(JG, JG, seq2R, convJJ);
+				CheConvKernel::cauchyRR(KG, KG, seq2R, convKK);
+				vec RHSIG3temp = -Pm.col(lvl + 1) + convVJK + (convJJ + convKK) % Rs;
+				vec RHSIG3 = plan.pShareBal % RHSIG3temp - RHSIG3temp(idxBalSyn) % pShare;
 				RHSIG3(idxBal).fill(0.);
-				vec RHSIG = spsolve(MatGB, join_cols(RHSIG1, RHSIG2, RHSIG3));
+				vec RHSIG(3 * nSyn, fill::zeros);
+				if (nSyn > 0 && !this->genSolver->solve(RHSIG, join_cols(RHSIG1, RHSIG2, RHSIG3))) {
+					cerr << logTag << "Solve with MatGB failed at level " << lvl << "." << endl;
+					return NULL;
+				}
 				vec RHSIGJK = MatGTrans * RHSIG;
 				RHSIGr = RHSIGJK(span(0, nbus - 1));
 				RHSIGi = RHSIGJK(span(nbus, 2 * nbus - 1));
@@ -1173,10 +1179,16 @@ namespace che {
 				DEBUG_PRINT_MAT(Q)
 				DEBUG_PRINT_MAT(W)
 				DEBUG_PRINT_MAT(Ysh)
-				cx_vec RHS1 = sum(cx_mat(-P.cols(seq2.col(0)), Q.cols(seq2.col(0)) + Qxtra.cols(seq2.col(0))) % conj(W.cols(seq2.col(1))), 1) +
-							  Ysh % V.col(lvl);
-				vec RHS2 = -0.5 * real(sum(V.cols(seq2.col(0)) % conj(V.cols(seq2.col(1))), 1));
-				cx_vec RHS3 = sum(-W.cols(seq2.col(0)) % V.cols(seq2.col(1)), 1);
+				// (-P + j(Q + Qxtra)) * conj(W), accumulated term by term
+				CheConvKernel::cauchyRConj(Q, W, seq2, convCx);
+				CheConvKernel::cauchyRConj(Qxtra, W, seq2, convCx, true);
+				cx_vec RHS1 = cx_double(0.0, 1.0) * convCx + dAlpha * Ysh % V.col(lvl);
+				CheConvKernel::cauchyRConj(P, W, seq2, convCx);
+				RHS1 -= convCx;
+				CheConvKernel::cauchyCConj(V, V, seq2, convCx);
+				vec RHS2 = -0.5 * real(convCx);
+				CheConvKernel::cauchyCC(W, V, seq2, convCx);
+				cx_vec RHS3 = -convCx;
 				/*DEBUG_PRINT_MAT(AG0)
 				DEBUG_PRINT_MAT(BG0)
 				DEBUG_PRINT_MAT(CCr)
@@ -1198,7 +1210,7 @@ namespace che {
 					RHS2 += 0.5 * VspSq2;
 
 				cx_vec compactRHS1 = RHS1(idxNonSw);
-				compactRHS1 += CheCompUtil::sp_submatrix<cx_double>(Y, idxNonSw, isw) * V(isw, uvec(1).fill(lvl + 1));
+				compactRHS1 += plan.YNonSwSw * V(isw, uvec(1).fill(lvl + 1));
 				/*vec RHS = join_cols(
 					join_cols(real(compactRHS1) + RHSILr(idxNonSw) + RHSIiLr(idxNonSw) - RHSIGr(idxNonSw),
 						imag(compactRHS1) + RHSILi(idxNonSw) + RHSIiLi(idxNonSw) - RHSIGi(idxNonSw)),
@@ -1208,61 +1220,54 @@ namespace che {
 					join_cols(real(compactRHS1) + RHSILr(idxNonSw) + RHSIiLr(idxNonSw) - RHSIGr(idxNonSw) - RHS3xr(idxNonSw),
 							  imag(compactRHS1) + RHSILi(idxNonSw) + RHSIiLi(idxNonSw) - RHSIGi(idxNonSw) - RHS3xi(idxNonSw)),
 					RHS2(ipv));
+				if (!ipvClamped.is_empty()) {
+					RHS(2 * (npq + npv) + ipvClamped).zeros();
+				}
 
 				DEBUG_PRINT_MAT(RHS1)
 				DEBUG_PRINT_MAT(RHS2)
 				DEBUG_PRINT_MAT(RHS3)
 				DEBUG_PRINT_MAT(RHS)
 
-				superlu_opts opts;
-				opts.allow_ugly = true;
-				opts.equilibrate = true;
-				opts.refine = superlu_opts::REF_NONE;
-				// vec x = spsolve(LHS_mat, RHS, "superlu",opts);
-
-				vec cb = RHS;
-				const mat &B = cb;
-				vec x = RHS;
-				// x.zeros(A.n_cols, B.n_cols);
-				// vec xx=spsolve(LHS_mat,RHS);
-				// xx.print("xx");
-
-				const bool status_x = sp_auxlib::wrap_to_supermatrix(superX, x);
-				const bool status_b = sp_auxlib::wrap_to_supermatrix(superB, B);
-				bool use_iter_solver = 0;
+				vec x;
 				if (lvl == 0) {
-					if (this->perm_c == NULL) {
-						options.ColPerm = arma::superlu::COLAMD;
-					} else {
-						// TODO - rygx: work with arma team to fix the enum slip issue
-						options.ColPerm = static_cast<arma::superlu::colperm_t>(8); // This represents the MY_PERMC in SuperLu 6.0
-						arrayops::copy(perm_c, this->perm_c, A.n_cols + 1);
+					// With the stale-LU mode the factorization of an earlier stage only preconditions BiCGSTAB
+					// on the new LHS_mat. Otherwise the stages share the sparsity pattern of LHS_mat and the
+					// previous factorization is refactorized whenever the solver can do so safely.
+					staleLu = this->useStaleLu && this->linSolver->isFactored() && this->linSolver->hasSamePattern(LHS_mat);
+					if (!staleLu) {
+						bool factOk = this->linSolver->isFactored() ? this->linSolver->refactor(LHS_mat) : this->linSolver->factor(LHS_mat);
+						if (!factOk) {
+							cerr << logTag << "Factorization of LHS_mat failed." << endl;
+							return NULL;
+						}
 					}
-					options.Fact = arma::superlu::DOFACT;
-					if (this->perm_r == NULL || this->etree == NULL || true) {
-						options.Fact = arma::superlu::DOFACT;
+				}
+				bool solved = false;
+				if (staleLu) {
+					double iterErr = 0.0;
+					int iterCount = 0;
+					int iterFlag = 0;
+					x.zeros(RHS.n_rows);
+					bicgstab(LHS_mat, x, RHS, *this->linSolver, this->staleLuMaxIter, this->staleLuTol, &iterErr, &iterCount, &iterFlag);
+					stageIter += iterCount;
+					if (iterFlag == 0) {
+						solved = true;
 					} else {
-						options.Fact = arma::superlu::SamePattern;
-						arrayops::copy(perm_r, this->perm_r, A.n_rows + 1);
-						arrayops::copy(etree, this->etree, A.n_cols + 1);
-					}
-
-					arma_wrapper(dgssvx)(&options, &superA, perm_c, perm_r, etree, equed, R, C, &superL, &superU, &work[0], lwork, &superB, &superX, &rpg, &rcond, ferr, berr, &glu, &mu, &stat, &superInfo);
-
-					if (this->perm_c == NULL) {
-						this->perm_c = new int[A.n_cols + 1];
-					}
-					if (this->perm_r == NULL) {
-						this->perm_r = new int[A.n_rows + 1];
-					}
-					if (this->etree == NULL) {
-						this->etree = new int[A.n_cols + 1];
+						// Too many iterations: the old factors are too far off, refactorize and solve directly from here on.
+						staleLu = false;
+						this->nStaleLuFallback++;
+						cout << logTag << "Stale LU: BiCGSTAB stopped at level " << lvl << " after " << stageIter
+							 << " iterations (err=" << iterErr << "), refactorizing." << endl;
+						if (!this->linSolver->refactor(LHS_mat)) {
+							cerr << logTag << "Factorization of LHS_mat failed." << endl;
+							return NULL;
+						}
 					}
-					arrayops::copy(this->perm_c, perm_c, A.n_cols + 1);
-					arrayops::copy(this->perm_r, perm_r, A.n_rows + 1);
-					arrayops::copy(this->etree, etree, A.n_cols + 1);
-				} else {
-					arma_wrapper(dgstrs)(options.Trans, &superL, &superU, perm_c, perm_r, &superX, &stat, &superInfo);
+				}
+				if (!solved && !this->linSolver->solve(x, RHS)) {
+					cerr << logTag << "Solve with LHS_mat failed at level " << lvl << "." << endl;
+					return NULL;
 				}
 
 				// x.print("x");
@@ -1284,23 +1289,23 @@ namespace che {
 				DEBUG_PRINT_MAT(Q)
 
 				// Aux Ind
-				for (int i = 0; i < nInd; i++) {
-					vec tempvi(2);
-					tempvi << real(V(indIdx(i), lvl + 1)) << imag(V(indIdx(i), lvl + 1));
-					vec tempx = LHS_MatInd_Full[i] * tempvi + rhsBus.row(i).t();
-					IL(i, lvl + 1) = cx_double(tempx(2), tempx(3));
-					IR(i, lvl + 1) = cx_double(tempx(0), tempx(1));
-					s(i, lvl + 1) = tempx(4);
-					Vm(i, lvl + 1) = V(indIdx(i), lvl + 1) - IL(i, lvl + 1) * Z1(i);
+				if (nInd > 0) {
+					cx_vec Vind = V(indIdx, uvec(1).fill(lvl + 1)).as_col();
+					mat &tempx = plan.tempx;
+					tempx = rhsBus;
+					CheSmallMatKernel::mul<5, 2, 1>(LHS_MatInd_Full, join_rows(real(Vind), imag(Vind)), tempx, true);
+					IL.col(lvl + 1) = cx_vec(tempx.col(2), tempx.col(3));
+					IR.col(lvl + 1) = cx_vec(tempx.col(0), tempx.col(1));
+					s.col(lvl + 1) = tempx.col(4);
+					Vm.col(lvl + 1) = Vind - IL.col(lvl + 1) % Z1;
 				}
 
 				// Aux Zip
-				IiL.col(lvl + 1) = cx_vec(LHS_MatZip.col(0), LHS_MatZip.col(2)) % real(V(zipIdx, uvec(1).fill(lvl + 1))) +
-								   cx_vec(LHS_MatZip.col(1), LHS_MatZip.col(3)) % imag(V(zipIdx, uvec(1).fill(lvl + 1))) +
-								   cx_vec(RHSIiLr_full, RHSIiLi_full);
-				BiL.col(lvl + 1) = Mat_BZip.col(0) % real(V(zipIdx, uvec(1).fill(lvl + 1))) +
-								   Mat_BZip.col(1) % imag(V(zipIdx, uvec(1).fill(lvl + 1))) +
-								   RHS_BZip;
+				Vzip = V(zipIdx, uvec(1).fill(lvl + 1)).as_col();
+				VzipR = real(Vzip);
+				VzipI = imag(Vzip);
+				IiL.col(lvl + 1) = plan.zipLhsC % VzipR + plan.zipLhsD % VzipI + cx_vec(RHSIiLr_full, RHSIiLi_full);
+				BiL.col(lvl + 1) = Mat_BZip.col(0) % VzipR + Mat_BZip.col(1) % VzipI + RHS_BZip;
 
 				// Aux Syn
 				vec IGJKd = MatGBiA * join_cols(real(V.col(lvl + 1)), imag(V.col(lvl + 1))) + RHSIG;
@@ -1323,8 +1328,19 @@ namespace che {
 				DEBUG_PRINT_MAT(Cd)
 				DEBUG_PRINT_MAT(Sd);
 			}
+			this->levelTime += pctimer() - levelStart;
+			this->nLevels += nlvl;
+
+			if (staleLu) {
+				this->nStaleLuSaved++;
+				this->staleLuIterations += stageIter;
+				cout << logTag << "Stale LU: " << stageIter << " BiCGSTAB iterations over " << nlvl << " levels, factorization saved." << endl;
+			} else if (stageIter > 0) {
+				this->staleLuIterations += stageIter;
+			}
 
-			CheSolution *psol = new CheSolutionPade(stateIdx.nState, nlvl + 1);
+			CheSolutionPade *psol = new CheSolutionPade(stateIdx.nState, nlvl + 1);
+			psol->nThreads = nSolverThreads;
 			psol->solution.rows(stateIdx.vrIdx) = real(V);
 			psol->solution.rows(stateIdx.viIdx) = imag(V);
 			psol->solution.rows(stateIdx.qIdx) = Q;
@@ -1333,21 +1349,6 @@ namespace che {
 			psol->solution.rows(stateIdx.mPgIdx) = Pm;
 			psol->solution.rows(stateIdx.mEfIdx) = Ef;
 
-			arma::superlu::free_stat(&stat);
-
-			arma::superlu::free(berr);
-			arma::superlu::free(ferr);
-			arma::superlu::free(C);
-			arma::superlu::free(R);
-			arma::superlu::free(etree);
-			arma::superlu::free(perm_c);
-			arma::superlu::free(perm_r);
-
-			sp_auxlib::destroy_supermatrix(superU);
-			sp_auxlib::destroy_supermatrix(superL);
-			sp_auxlib::destroy_supermatrix(superA);
-			sp_auxlib::destroy_supermatrix(superB);
-			sp_auxlib::destroy_supermatrix(superX);
 
 			return psol;
 		}
@@ -1357,6 +1358,73 @@ namespace che {
 		}
 
 		int ChePfCalculator::calc() {
+			qClamp.reset();
+			nQLimitSwitches = 0;
+			int flag = solveStages();
+			// A Q-limit round only overrides the warm start of its own re-solve, the caller's one is restored.
+			CheState callerWarmState = warmState;
+			for (int round = 0; enforceQLimits && flag == 0 && round < maxQLimitRounds; round++) {
+				CheState st = exportResult();
+				if (!updateQClamp(st)) {
+					break;
+				}
+				// Only the switched buses changed: embed from the solution just found instead of the flat start.
+				// The first LHS_mat of the re-solve is taken at that solution, while the last factorization
+				// belongs to the start of the last stage, so the two differ in every voltage column and a
+				// low-rank correction cannot replace the numeric refactorization. The switched rows keep the
+				// pattern, so the symbolic analysis is reused.
+				resetStages();
+				setWarmStart(st);
+				flag = solveStages();
+			}
+			warmState = callerWarmState;
+			return flag;
+		}
+
+		bool ChePfCalculator::updateQClamp(CheState &st) {
+			if (qClamp.is_empty()) {
+				qClamp = vec(baseSys.nBus).fill(datum::nan);
+			}
+			if (baseSys.nPv <= 0) {
+				return false;
+			}
+			const CheStateIdx &idx = *st.stateIdx;
+			uvec pvBus = C_IDX(baseSys.get_pvs_busNumber_vec());
+			const vec &qMax = baseSys.get_pvs_qMax_vec();
+			const vec &qMin = baseSys.get_pvs_qMin_vec();
+			const vec &vSet = baseSys.get_pvs_vMag_vec();
+			const double qTol = this->compOpt.diffTol;
+			int nToPq = 0;
+			int nToPv = 0;
+			for (uword i = 0; i < pvBus.n_rows; i++) {
+				if (qMax(i) <= qMin(i)) {
+					continue; // no limits given
+				}
+				uword b = pvBus(i);
+				double q = st.state(idx.qIdx(b));
+				if (!std::isfinite(qClamp(b))) {
+					if (q > qMax(i) + qTol || q < qMin(i) - qTol) {
+						qClamp(b) = q > qMax(i) ? qMax(i) : qMin(i);
+						st.state(idx.qIdx(b)) = qClamp(b);
+						nToPq++;
+					}
+				} else {
+					// back to PV once the voltage at the limit has crossed the set-point
+					double vMag = std::abs(cx_double(st.state(idx.vrIdx(b)), st.state(idx.viIdx(b))));
+					if ((qClamp(b) == qMax(i) && vMag > vSet(i)) || (qClamp(b) == qMin(i) && vMag < vSet(i))) {
+						qClamp(b) = datum::nan;
+						nToPv++;
+					}
+				}
+			}
+			if (nToPq + nToPv > 0) {
+				nQLimitSwitches += nToPq + nToPv;
+				cout << logTag << "Q limits: " << nToPq << " PV buses switched to PQ, " << nToPv << " back to PV." << endl;
+			}
+			return nToPq + nToPv > 0;
+		}
+
+		int ChePfCalculator::solveStages() {
 			double alpha = 0.0;
 			double alphax = 0.0;
 			double alphaConfirm = 0.0;
@@ -1368,6 +1436,7 @@ namespace che {
 			double diffTolMax = this->compOpt.diffTolMax;
 			double segment = this->compOpt.segLen;
 			int maxCount = 10;
+			int nProbe = 8;
 			int maxNoMove = 5;
 			int noMove = 0;
 			CheSolution *pSol = NULL;
@@ -1385,6 +1454,10 @@ namespace che {
 				CheSingleEmbedSystem *pCurrEmbeddedSys = this->cheList.back();
 				if (lastEmbeddedSys != pCurrEmbeddedSys || pSol == NULL) {
 					pSol = this->getCheSolution();
+					if (pSol == NULL) {
+						cout << logTag << "Stage could not be solved, exit!" << endl;
+						break;
+					}
 				}
 
 				/*CheSolutionPade* pSolX = (CheSolutionPade*)pSol;
@@ -1397,23 +1470,32 @@ namespace che {
 				pSolX->numerator.raw_print(cout, "Num");
 				pSolX->denomenator.raw_print(cout, "Den");*/
 
+				// Each pass probes nProbe equally spaced alphas of (alphaLeft, alphaRight] in one batch and
+				// narrows the bracket to the last feasible and the first infeasible probe.
 				double alphaLeft = 0;
 				double alphaRight = alphax;
 				double absDiff = 0.0;
+				double leftDiff = -1.0;
 				while (true) {
-					vec diff = pCurrEmbeddedSys->calcEqBalance(pSol, alphax);
-					absDiff = max(abs(diff));
-					if (absDiff < diffTol && abs(alphax - alpha / alphaPreMult) < alphaTol / 1000.0) {
+					vec probes = alphaLeft + (alphaRight - alphaLeft) / nProbe * regspace<vec>(1, nProbe);
+					probes(nProbe - 1) = alphaRight;
+					rowvec maxDiff = max(abs(pCurrEmbeddedSys->calcEqBalances(pSol, probes)), 0);
+					if (maxDiff(nProbe - 1) < diffTol) {
+						absDiff = maxDiff(nProbe - 1);
 						alphaLeft = alphaRight;
-					} else {
-						if (absDiff < diffTol) {
-							alphaLeft = alphax;
-							alphax = (alphaLeft + alphaRight) / 2.0;
-						} else {
-							alphaRight = alphax;
-							alphax = (alphaLeft + alphaRight) / 2.0;
-						}
+						break;
 					}
+					int firstBad = 0;
+					while (maxDiff(firstBad) < diffTol) {
+						firstBad++;
+					}
+					if (firstBad > 0) {
+						alphaLeft = probes(firstBad - 1);
+						leftDiff = maxDiff(firstBad - 1);
+					}
+					alphaRight = probes(firstBad);
+					absDiff = leftDiff >= 0.0 ? leftDiff : maxDiff(firstBad);
+
 					double alphaTolTemp = 0.03 * alphaRight;
 					if (alphaTolTemp < alphaTol) {
 						alphaTolTemp = alphaTol;
@@ -1445,13 +1527,13 @@ namespace che {
 				}
 				alpha = alphax;
 				alphaConfirm += alpha;
-				cout << "Step=" << alphaConfirm << ", added=" << alpha << ", (maxDiff<" << diffTol << ")." << endl;
+				cout << logTag << "Step=" << alphaConfirm << ", added=" << alpha << ", (maxDiff<" << diffTol << ")." << endl;
 
 				if (alpha == 0.0) {
-					cout << "Step did not move!" << endl;
+					cout << logTag << "Step did not move!" << endl;
 					noMove++;
 					if (noMove >= maxNoMove) {
-						cout << "Reached consecutive max no move, exit!" << endl;
+						cout << logTag << "Reached consecutive max no move, exit!" << endl;
 						if (pSol != NULL) {
 							delete pSol;
 							pSol = NULL;
@@ -1459,7 +1541,7 @@ namespace che {
 						break;
 					}
 					if (diffTol >= diffTolMax) {
-						cout << "Max DiffTol reached and not move, exit!" << endl;
+						cout << logTag << "Max DiffTol reached and not move, exit!" << endl;
 						if (pSol != NULL) {
 							delete pSol;
 							pSol = NULL;
@@ -1470,19 +1552,44 @@ namespace che {
 					if (absDiff > diffTol) {
 						diffTol = absDiff;
 					}
-					cout << "Enlarge tol! (Tol=" << diffTol << ")." << endl;
+					cout << logTag << "Enlarge tol! (Tol=" << diffTol << ")." << endl;
 					if (pSol != NULL) {
 						delete pSol;
 						pSol = NULL;
 					}
 				} else {
 					noMove = 0;
-					CheState curState(pCurrEmbeddedSys->baseSys, pSol->getSolValue(alpha));
+					recordTrajectory(pSol, *pCurrEmbeddedSys->initState.stateIdx, alphaConfirm - alpha, alphaConfirm);
+					CheState curState(pCurrEmbeddedSys->initState.stateIdx, pSol->getSolValue(alpha));
 					CheSingleEmbedSystem *nextSystem = pCurrEmbeddedSys->getNewEmbeddedSystem(curState, alpha);
 					this->cheList.push_back(nextSystem);
 					this->solList.push_back(pSol);
+					if (minStep > 0.0 && alpha < minStep && alphaConfirm < 1 - alphaTol / 1000.0) {
+						cout << logTag << "Step collapsed below " << minStep << ", stop at " << alphaConfirm << "." << endl;
+						break;
+					}
 				}
 			}
+			this->alphaReached = alphaConfirm;
+
+			if (nLevels > 0) {
+				cout << logTag << "Level loop: " << nLevels << " levels in " << levelTime * 1000.0 << " ms ("
+					 << levelTime * 1000.0 / nLevels << " ms/level)." << endl;
+			}
+			if (linSolver != NULL) {
+				const CheSparseSolverStats &st = linSolver->stats;
+				cout << logTag << "LU reuse (" << linSolver->getName() << "): " << st.nRefactor + st.nRepivot << " of "
+					 << st.nFactor + st.nRefactor + st.nRepivot << " stages reused the symbolic factorization (same pivots="
+					 << st.nRefactor << ", repivoted=" << st.nRepivot << ", full=" << st.nFactor << ", analyses=" << st.nAnalyze
+					 << ", LHS patterns=" << lhsAssembler.nPatternBuilds << ")." << endl;
+				if (st.nLowRank > 0) {
+					cout << logTag << "Low-rank updates: " << st.nLowRank << " stages solved with the base factorization." << endl;
+				}
+			}
+			if (useStaleLu) {
+				cout << logTag << "Stale LU: " << nStaleLuSaved << " factorizations saved, " << nStaleLuFallback << " fallbacks, "
+					 << staleLuIterations << " BiCGSTAB iterations." << endl;
+			}
 
 			if (alphaConfirm >= 1 - alphaTol / 1000.0) {
 				this->reachesMaxAlpha = true;
@@ -1493,8 +1600,25 @@ namespace che {
 			}
 		}
 
+		void ChePfCalculator::recordTrajectory(CheSolution *sol, const CheStateIdx &idx, double alphaStart, double alphaEnd) {
+			uword nRec = trajStates.n_cols;
+			if (nRec >= trajAlphas.n_rows || trajAlphas(nRec) > alphaEnd + 1e-12) {
+				return;
+			}
+			shared_ptr<const CheStateIdx> fullIdx = CheCompUtil::getSharedStateIdx(baseSys);
+			while (nRec < trajAlphas.n_rows && trajAlphas(nRec) <= alphaEnd + 1e-12) {
+				double a = trajAlphas(nRec) > alphaStart ? trajAlphas(nRec) - alphaStart : 0.0;
+				trajStates.insert_cols(nRec, CheCompUtil::mapState(sol->getSolValue(a), idx, *fullIdx));
+				nRec++;
+			}
+		}
+
 		CheState ChePfCalculator::exportResult() {
-			return cheList.back()->initState;
+			// the calculation runs on the compact PF layout, callers get the full layout
+			const CheState &st = cheList.back()->initState;
+			CheState res(cheList.back()->baseSys);
+			res.state = CheCompUtil::mapState(st.state, *st.stateIdx, *res.stateIdx);
+			return res;
 		}
 
 		void ChePfCalculator::writeMatFile(const char *fileName, double interval) {
@@ -1502,8 +1626,30 @@ namespace che {
 		}
 
 		void ChePfCalculator::writeMatFile(const char *fileName) {
-			vec result = cheList.back()->initState.state;
+			writeStateMatFile(fileName, exportResult().state);
+		}
 
+		bool ChePfCalculator::readStateMatFile(const char *fileName, vec &state) {
+			mat_t *matfp = Mat_Open(fileName, MAT_ACC_RDONLY);
+			if (NULL == matfp) {
+				cerr << "Error opening MAT file \"" << fileName << "\"." << endl;
+				return false;
+			}
+			matvar_t *matvar = Mat_VarRead(matfp, "s");
+			bool ok = matvar != NULL && matvar->class_type == MAT_C_DOUBLE && matvar->rank == 2 && matvar->dims[1] == 1;
+			if (ok) {
+				state = vec((double *)matvar->data, matvar->dims[0]);
+			} else {
+				cerr << "No state vector 's' in \"" << fileName << "\"." << endl;
+			}
+			if (matvar != NULL) {
+				Mat_VarFree(matvar);
+			}
+			Mat_Close(matfp);
+			return ok;
+		}
+
+		void ChePfCalculator::writeStateMatFile(const char *fileName, const vec &result) {
 			mat solutionMat(result.n_rows, 1, fill::zeros);
 			solutionMat.col(0) = result;
 
@@ -1528,17 +1674,13 @@ namespace che {
 		}
 
 		ChePfCalculator::~ChePfCalculator() {
-			if (perm_c != NULL) {
-				delete[] perm_c;
-				perm_c = NULL;
-			}
-			if (perm_r != NULL) {
-				delete[] perm_r;
-				perm_r = NULL;
+			if (linSolver != NULL) {
+				delete linSolver;
+				linSolver = NULL;
 			}
-			if (etree != NULL) {
-				delete[] etree;
-				etree = NULL;
+			if (genSolver != NULL) {
+				delete genSolver;
+				genSolver = NULL;
 			}
 
 			// if(perm_ci!=NULL){
@@ -28,20 +28,36 @@
 #define _Che_ChePFCalculator_H_
 
 #include "util/AbstractCheCalculator.h"
+#include "util/CheSparseSolver.h"
+#include "pf/ChePFResidualEvaluator.h"
+#include "pf/ChePFLhsAssembler.h"
 
 using namespace che::util;
 
 namespace che {
 	namespace core {
+		// state blocks used by the power flow
+		const int PF_STATE_BLOCKS = CHESTATE_V | CHESTATE_Q | CHESTATE_IND_SLIP | CHESTATE_SYN_DELTA | CHESTATE_SYN_PG | CHESTATE_SYN_EF;
+
 		class ChePfEmbedSystem : public CheSingleEmbedSystem {
 		public:
+			ChePfResidualEvaluator residualEval; // alpha-independent part of calcEqBalance
+			CheState warmBase;					 // converged state a warm start embeds from, empty for a flat start
+			vec qClamp;							 // per bus, reactive power a PV bus is held at (switched to PQ), NaN if free
+
 			ChePfEmbedSystem(const chedata::PsatDataSet &sys);
 
 			ChePfEmbedSystem(const chedata::PsatDataSet &sys, const CheState &st, double alpha = 0);
 
+			ChePfEmbedSystem(const chedata::PsatDataSet &sys, const CheState &st, double alpha, const CheState &warmBase);
+
 			virtual vec calcEqBalance(CheSolution *sol, double alpha);
 
+			virtual mat calcEqBalances(CheSolution *sol, const vec &alphas);
+
 			virtual CheSingleEmbedSystem *getNewEmbeddedSystem(const CheState &st, double alpha);
+
+			void setQClamp(const vec &qClamp);
 		};
 
 		class ChePfCalculator : public AbstractCheCalculator {
@@ -50,12 +66,34 @@ namespace che {
 			vec paraPm;
 			vec pShare;
 			uvec islands;
-			int *perm_c;
-			int *perm_r;
-			int *etree;
-			// int* perm_ci;
-			// int* perm_ri;
-			// int* etreei;
+			string logTag; // prefix of the progress messages printed by calc()
+			int solverType;		// CheSparseSolverType used for LHS_mat
+			int nSolverThreads; // threads of the parallel solver, 0 for all hardware threads
+			CheSparseSolver *linSolver; // factorization of LHS_mat, kept across stages
+			CheSparseSolver *genSolver; // factorization of the generator block MatGB, kept across stages
+			ChePfLhsAssembler lhsAssembler; // CSC pattern of LHS_mat, kept while the network does not change
+			double levelTime; // seconds spent in the level loops of getCheSolution
+			int nLevels;	  // levels computed over all stages
+			// Stale-LU mode: solve a stage with BiCGSTAB preconditioned by the LU of an earlier stage and only
+			// refactorize when a level needs more than staleLuMaxIter iterations.
+			bool useStaleLu;
+			int staleLuMaxIter;
+			double staleLuTol;
+			int nStaleLuSaved;
+			int nStaleLuFallback;
+			int staleLuIterations;
+			// Warm start: embed from the converged state of a nearby operating point instead of the flat start.
+			CheState warmState;
+			double minStep;		 // > 0 stops calc() once an accepted step is shorter, e.g. at the nose of a PV curve
+			double alphaReached; // alpha reached by the last calc()
+			vec trajAlphas;		 // ascending alphas at which calc() records the state
+			mat trajStates;		 // recorded states in the full layout, one column per reached entry of trajAlphas
+			// Q limits: after convergence PV buses outside their qMax/qMin are held at the limit (PV->PQ) and the
+			// case is warm-started again, for at most maxQLimitRounds rounds.
+			bool enforceQLimits;
+			int maxQLimitRounds;
+			vec qClamp; // per bus, NaN for buses not held at a limit
+			int nQLimitSwitches;
 
 			ChePfCalculator(const chedata::PsatDataSet &sys,
 							const CheCompOptions &compOpt,
@@ -73,15 +111,42 @@ namespace che {
 
 			virtual CheState exportResult();
 
+			/**
+			 * @brief Starts the next calc() from the converged state prev of a nearby operating point of the same network.
+			 *
+			 * Only the difference of the injections, generator set-points and voltage targets to prev is embedded.
+			 * prev may use any state layout of the set. Returns false and keeps the flat start if it does not fit.
+			 */
+			bool setWarmStart(const CheState &prev);
+
+			/**
+			 * @brief Drops the stages and solutions of the last calc() so that calc() can solve baseSys again.
+			 *
+			 * The factorizations of linSolver and genSolver are kept, so the next point of a time series with the
+			 * same network only refactors numerically.
+			 */
+			void resetStages();
+
 			virtual ~ChePfCalculator();
 
 			virtual void writeMatFile(const char *);
 
 			virtual void writeMatFile(const char *, double);
 
+			static void writeStateMatFile(const char *fileName, const vec &state);
+
+			static bool readStateMatFile(const char *fileName, vec &state);
+
 			virtual CheSingleEmbedSystem *getNewStage();
 
 			virtual CheSolution *getCheSolution();
+
+		private:
+			int solveStages();
+
+			bool updateQClamp(CheState &st);
+
+			void recordTrajectory(CheSolution *sol, const CheStateIdx &idx, double alphaStart, double alphaEnd);
 		};
 
 	} // namespace core
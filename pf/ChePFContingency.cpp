@@ -0,0 +1,354 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#include "pf/ChePFContingency.h"
+#include "util/CheCompUtil.h"
+#include "util/CheThreadPool.h"
+#include "matio.h"
+#include "nvwa/pctimer.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+
+namespace che {
+	namespace core {
+		static void setBusLimits(vec &busLimit, const uvec &bus, const vec &limit) {
+			for (uword i = 0; i < bus.n_rows; i++) {
+				if (limit(i) > 0.0) {
+					busLimit(C_IDX(bus(i))) = limit(i);
+				}
+			}
+		}
+
+		static bool readIndexVariable(mat_t *matfp, const char *name, int nMax, std::vector<int> &index) {
+			matvar_t *matvar = Mat_VarRead(matfp, name);
+			if (matvar == NULL) {
+				return true;
+			}
+			bool ok = matvar->class_type == MAT_C_DOUBLE && matvar->rank == 2;
+			if (ok) {
+				const double *data = (const double *)matvar->data;
+				size_t n = matvar->dims[0] * matvar->dims[1];
+				for (size_t i = 0; i < n; i++) {
+					int idx = (int)data[i];
+					if (idx < 1 || idx > nMax) {
+						cerr << "Index " << idx << " of '" << name << "' is out of range 1.." << nMax << "." << endl;
+						ok = false;
+						break;
+					}
+					index.push_back(C_IDX(idx));
+				}
+			} else {
+				cerr << "Variable '" << name << "' should be a real vector." << endl;
+			}
+			Mat_VarFree(matvar);
+			return ok;
+		}
+
+		ChePfContingencyAnalysis::ChePfContingencyAnalysis(const chedata::PsatDataSet &sys, const CheCompOptions &compOpt, int nThreads)
+			: baseSys(sys), compOpt(compOpt) {
+			if (!baseSys.isFormatted) {
+				baseSys.renumberBuses();
+			}
+			this->nThreads = nThreads;
+			this->solverType = CHESPSOLVER_SUPERLU;
+			this->lowRankMaxRank = 16;
+			this->enforceQLimits = false;
+
+			busVMax = vec(baseSys.nBus, fill::zeros);
+			busVMin = vec(baseSys.nBus, fill::zeros);
+			if (baseSys.nPq > 0) {
+				setBusLimits(busVMax, baseSys.get_pqs_busNumber_vec(), baseSys.get_pqs_vMax_vec());
+				setBusLimits(busVMin, baseSys.get_pqs_busNumber_vec(), baseSys.get_pqs_vMin_vec());
+			}
+			if (baseSys.nPv > 0) {
+				setBusLimits(busVMax, baseSys.get_pvs_busNumber_vec(), baseSys.get_pvs_vMax_vec());
+				setBusLimits(busVMin, baseSys.get_pvs_busNumber_vec(), baseSys.get_pvs_vMin_vec());
+			}
+			if (baseSys.nSw > 0) {
+				setBusLimits(busVMax, baseSys.get_sws_busNumber_vec(), baseSys.get_sws_vMax_vec());
+				setBusLimits(busVMin, baseSys.get_sws_busNumber_vec(), baseSys.get_sws_vMin_vec());
+			}
+		}
+
+		void ChePfContingencyAnalysis::addAllOutages() {
+			for (int i = 0; i < baseSys.nLine; i++) {
+				if (baseSys.lines[i].status) {
+					contingencies.push_back({CHECTG_BRANCH, i});
+				}
+			}
+			for (int i = 0; i < baseSys.nPv; i++) {
+				contingencies.push_back({CHECTG_GEN, i});
+			}
+		}
+
+		bool ChePfContingencyAnalysis::readContingencyMatFile(const char *fileName) {
+			mat_t *matfp = Mat_Open(fileName, MAT_ACC_RDONLY);
+			if (NULL == matfp) {
+				cerr << "Error opening MAT file \"" << fileName << "\"." << endl;
+				return false;
+			}
+			std::vector<int> branchIdx;
+			std::vector<int> genIdx;
+			bool ok = readIndexVariable(matfp, "branch", baseSys.nLine, branchIdx) &&
+					  readIndexVariable(matfp, "gen", baseSys.nPv, genIdx);
+			Mat_Close(matfp);
+			if (!ok) {
+				return false;
+			}
+			for (int i : branchIdx) {
+				contingencies.push_back({CHECTG_BRANCH, i});
+			}
+			for (int i : genIdx) {
+				contingencies.push_back({CHECTG_GEN, i});
+			}
+			return true;
+		}
+
+		int ChePfContingencyAnalysis::solveBase() {
+			ChePfCalculator calculator(baseSys, compOpt);
+			calculator.solverType = solverType;
+			calculator.nSolverThreads = nThreads;
+			calculator.logTag = "[Base] ";
+			calculator.enforceQLimits = enforceQLimits;
+			pctimer_t stTime = pctimer();
+			int flag = calculator.calc();
+			baseState = calculator.exportResult();
+			baseResult = checkLimits(baseSys, baseState);
+			baseResult.flag = flag == 0 ? CHECTG_CONVERGED : CHECTG_DIVERGED;
+			baseResult.time = pctimer() - stTime;
+
+			// The base factorization of the low-rank updates is the first-stage LHS_mat of the base case
+			// warm-started from its own solution, which is what every branch outage builds apart from the
+			// columns of its two buses. Nothing moves, so that calc() takes a single stage.
+			baseLhs.reset();
+			if (flag == 0 && lowRankMaxRank > 0) {
+				ChePfCalculator warmCalculator(baseSys, compOpt);
+				warmCalculator.logTag = "[Base factorization] ";
+				warmCalculator.solverType = solverType;
+				warmCalculator.nSolverThreads = nThreads;
+				warmCalculator.setWarmStart(baseState);
+				warmCalculator.calc();
+				baseLhs = warmCalculator.lhsAssembler.getMatrix();
+			}
+			return flag;
+		}
+
+		chedata::PsatDataSet ChePfContingencyAnalysis::getOutageSystem(const ChePfContingency &ctg) const {
+			chedata::PsatDataSet sys(baseSys);
+			if (ctg.type == CHECTG_BRANCH) {
+				chedata::Line *lines = sys.mutable_lines();
+				lines[ctg.index].status = 0;
+				sys.invalidateColumns();
+			} else {
+				// the bus of the generator becomes a load bus with the remaining injections
+				int nPv = sys.nPv;
+				std::vector<chedata::PV> pvs(sys.pvs, sys.pvs + nPv);
+				chedata::PV *newPvs = sys.alloc_pvs(nPv - 1);
+				for (int i = 0, j = 0; i < nPv; i++) {
+					if (i != ctg.index) {
+						newPvs[j++] = pvs[i];
+					}
+				}
+				sys.invalidateInjections();
+			}
+			return sys;
+		}
+
+		ChePfContingencyResult ChePfContingencyAnalysis::checkLimits(const chedata::PsatDataSet &sys, const CheState &st) const {
+			ChePfContingencyResult res;
+			const CheStateIdx &idx = *st.stateIdx;
+			cx_vec V(st.state(idx.vrIdx), st.state(idx.viIdx));
+			vec vMag = abs(V);
+
+			double worstDev = 0.0;
+			for (int i = 0; i < sys.nBus; i++) {
+				double dev = 0.0;
+				if (busVMax(i) > 0.0 && vMag(i) > busVMax(i)) {
+					dev = vMag(i) - busVMax(i);
+				} else if (busVMin(i) > 0.0 && vMag(i) < busVMin(i)) {
+					dev = busVMin(i) - vMag(i);
+				}
+				if (dev > 0.0) {
+					res.nVoltViol++;
+					if (dev > worstDev) {
+						worstDev = dev;
+						res.worstBus = i;
+						res.worstVMag = vMag(i);
+					}
+				}
+			}
+
+			if (sys.nLine > 0) {
+				shared_ptr<const CheYMatrix> yMatrix = CheCompUtil::getSharedYMatrix(sys);
+				uvec ifr = C_IDX(sys.get_lines_fromBus_vec());
+				uvec ito = C_IDX(sys.get_lines_toBus_vec());
+				cx_vec Vf = V(ifr);
+				cx_vec Vt = V(ito);
+				cx_vec Sfr = Vf % conj(yMatrix->ytrfr % (Vf - Vt) + yMatrix->yshfr % Vf);
+				cx_vec Sto = Vt % conj(yMatrix->ytrto % (Vt - Vf) + yMatrix->yshto % Vt);
+				vec sMax = sys.get_lines_sMax_vec();
+				uvec status = sys.get_lines_status_vec();
+				for (int i = 0; i < sys.nLine; i++) {
+					if (!status(i) || sMax(i) <= 0.0) {
+						continue;
+					}
+					double loading = std::max(abs(Sfr(i)), abs(Sto(i))) / sMax(i);
+					if (loading > 1.0) {
+						res.nOverload++;
+					}
+					if (loading > res.maxLoading) {
+						res.maxLoading = loading;
+						res.worstLine = i;
+					}
+				}
+			}
+			return res;
+		}
+
+		CheSparseSolver *ChePfContingencyAnalysis::makeOutageSolver() const {
+			if (lowRankMaxRank <= 0) {
+				return NULL;
+			}
+			CheSparseSolver *linSolver = new CheLowRankUpdateSolver(CheSparseSolverFactory::makeSolver(solverType, 1),
+																	CheSparseSolverFactory::makeSolver(solverType, 1), lowRankMaxRank);
+			if (baseLhs.n_nonzero > 0 && !linSolver->factor(baseLhs)) {
+				// the first outage then becomes the base of the updates
+				cerr << "Base factorization failed." << endl;
+			}
+			return linSolver;
+		}
+
+		ChePfContingencyResult ChePfContingencyAnalysis::solveContingency(int k, CheSparseSolver *&linSolver, CheSparseSolver *&genSolver) {
+			const ChePfContingency &ctg = contingencies[k];
+			ostringstream tag;
+			tag << "[Contingency " << k + 1 << "] ";
+			ChePfContingencyResult res;
+			pctimer_t stTime = pctimer();
+			try {
+				chedata::PsatDataSet sys = getOutageSystem(ctg);
+				uvec islands = CheCompUtil::searchIslands(sys);
+				if (islands.max() > 0) {
+					res.flag = CHECTG_ISLANDED;
+					cout << tag.str() << "Outage splits the network, not solved." << endl;
+					return res;
+				}
+				ChePfCalculator calculator(sys, compOpt, islands);
+				calculator.logTag = tag.str();
+				calculator.solverType = solverType;
+				calculator.nSolverThreads = 1; // the contingencies already occupy the threads
+				calculator.enforceQLimits = enforceQLimits;
+				calculator.linSolver = linSolver;
+				calculator.genSolver = genSolver;
+				calculator.setWarmStart(baseState);
+				// the calculator deletes the solvers it owns, take them back before a failure can drop them
+				linSolver = NULL;
+				genSolver = NULL;
+				int flag = calculator.calc();
+				linSolver = calculator.linSolver;
+				genSolver = calculator.genSolver;
+				calculator.linSolver = NULL;
+				calculator.genSolver = NULL;
+
+				res = checkLimits(sys, calculator.exportResult());
+				res.flag = flag == 0 ? CHECTG_CONVERGED : CHECTG_DIVERGED;
+			} catch (std::exception &e) {
+				res.flag = CHECTG_FAILED;
+				cerr << tag.str() << "Power flow failed: " << e.what() << endl;
+			}
+			res.time = pctimer() - stTime;
+			return res;
+		}
+
+		int ChePfContingencyAnalysis::run() {
+			int nCtg = contingencies.size();
+			results.assign(nCtg, ChePfContingencyResult());
+			int nWorkers = nThreads > 0 ? nThreads : CheThreadPool::getDefaultThreadCount();
+			if (nWorkers > nCtg) {
+				nWorkers = nCtg;
+			}
+			if (nWorkers <= 0) {
+				return 0;
+			}
+
+			// Contingencies differ widely in cost, so every worker pulls the next one as soon as it is free
+			// instead of taking a fixed share.
+			std::atomic<int> next(0);
+			CheThreadPool pool(nWorkers);
+			for (int w = 0; w < nWorkers; w++) {
+				pool.submit([this, nCtg, &next]() {
+					CheSparseSolver *genSolver = NULL;
+					CheSparseSolver *linSolver = makeOutageSolver();
+					for (int k = next++; k < nCtg; k = next++) {
+						results[k] = solveContingency(k, linSolver, genSolver);
+					}
+					delete linSolver;
+					delete genSolver;
+				});
+			}
+			pool.wait();
+
+			int nBad = 0;
+			for (int k = 0; k < nCtg; k++) {
+				const ChePfContingencyResult &res = results[k];
+				if (res.flag != CHECTG_CONVERGED || res.nVoltViol > 0 || res.nOverload > 0) {
+					nBad++;
+				}
+			}
+			cout << "Contingencies solved: " << nCtg << " on " << nWorkers << " threads, " << nBad << " with violations or without a solution." << endl;
+			return nBad;
+		}
+
+		bool ChePfContingencyAnalysis::writeSummary(const char *fileName) const {
+			ofstream out(fileName);
+			if (!out) {
+				cerr << "Error creating summary file \"" << fileName << "\"." << endl;
+				return false;
+			}
+			// buses are reported in the numbering of the input file
+			const map<int, int> &newToOld = *baseSys.newToOld;
+			auto busName = [&newToOld](int bus) {
+				map<int, int>::const_iterator itr = newToOld.find(bus + 1);
+				return itr != newToOld.end() ? itr->second : bus + 1;
+			};
+			auto writeRow = [&out, &busName](const string &name, const string &type, int element, const ChePfContingencyResult &res) {
+				out << name << "," << type << "," << element << "," << res.flag << "," << res.nVoltViol << ","
+					<< (res.worstBus >= 0 ? busName(res.worstBus) : 0) << "," << res.worstVMag << "," << res.nOverload << ","
+					<< res.worstLine + 1 << "," << res.maxLoading << "," << res.time << endl;
+			};
+
+			out << "contingency,type,element,flag,voltage_violations,worst_bus,worst_vmag,overloads,worst_branch,max_loading,time" << endl;
+			writeRow("0", "base", 0, baseResult);
+			for (size_t k = 0; k < contingencies.size() && k < results.size(); k++) {
+				const ChePfContingency &ctg = contingencies[k];
+				writeRow(to_string(k + 1), ctg.type == CHECTG_BRANCH ? "branch" : "gen", ctg.index + 1, results[k]);
+			}
+			return true;
+		}
+
+	} // namespace core
+} // namespace che
@@ -0,0 +1,124 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#ifndef _Che_ChePFContingency_H_
+#define _Che_ChePFContingency_H_
+
+#include "pf/ChePFCalculator.h"
+#include <vector>
+
+using namespace che::util;
+
+namespace che {
+	namespace core {
+		enum ChePfContingencyType { CHECTG_BRANCH,
+									CHECTG_GEN };
+
+		enum ChePfContingencyFlag { CHECTG_CONVERGED = 0,
+									CHECTG_DIVERGED = -1,
+									CHECTG_FAILED = -2,
+									CHECTG_ISLANDED = 1 };
+
+		class ChePfContingency {
+		public:
+			int type;
+			int index; // 0-based index of the line (CHECTG_BRANCH) or PV generator (CHECTG_GEN)
+		};
+
+		class ChePfContingencyResult {
+		public:
+			int flag = CHECTG_FAILED; // ChePfContingencyFlag
+			int nVoltViol = 0;
+			int worstBus = -1; // 0-based bus of the largest voltage limit violation
+			double worstVMag = 0.0;
+			int nOverload = 0;
+			int worstLine = -1; // 0-based line of the highest loading
+			double maxLoading = 0.0; // max(|S_from|, |S_to|) / sMax
+			double time = 0.0;
+		};
+
+		/**
+		 * @brief N-1 screening of branch and generator outages against a converged base case.
+		 *
+		 * Every contingency is solved by its own ChePfCalculator warm-started from the base-case state. The
+		 * contingencies are pulled from a shared counter by the workers of a CheThreadPool, and each worker lends
+		 * its linear solvers to the calculators it runs. With lowRankMaxRank > 0 the LHS_mat solver of a worker is
+		 * a CheLowRankUpdateSolver based on the first-stage LHS_mat without outage, so the first stage of a branch
+		 * outage is solved by a low-rank update of that factorization. Otherwise the ordering and symbolic
+		 * factorization are only redone when an outage changes the sparsity pattern. Voltages are checked against the vMax/vMin of the
+		 * PQ, PV and SW entries of a bus (0 means no limit) and branch loadings against sMax.
+		 */
+		class ChePfContingencyAnalysis {
+		public:
+			chedata::PsatDataSet baseSys;
+			CheCompOptions compOpt;
+			int nThreads;
+			int solverType; // CheSparseSolverType of the contingency calculators
+			int lowRankMaxRank; // largest number of changed LHS_mat columns solved by a low-rank update, 0 disables
+			bool enforceQLimits; // passed to the base and contingency calculators
+			CheState baseState;
+			sp_mat baseLhs; // first-stage LHS_mat of the base case warm-started from baseState, factored by every worker
+			ChePfContingencyResult baseResult;
+			std::vector<ChePfContingency> contingencies;
+			std::vector<ChePfContingencyResult> results;
+			vec busVMax;
+			vec busVMin;
+
+			ChePfContingencyAnalysis(const chedata::PsatDataSet &sys, const CheCompOptions &compOpt, int nThreads = 0);
+
+			/** @brief Adds the outage of every in-service line and every PV generator. */
+			void addAllOutages();
+
+			/** @brief Reads 1-based line indices from variable 'branch' and PV indices from 'gen' of a .mat file. */
+			bool readContingencyMatFile(const char *fileName);
+
+			/** @brief Solves the base case and keeps the LHS_mat the outages are updated from, returns the flag of its calc(). */
+			int solveBase();
+
+			/** @brief Solves all contingencies, returns the number that did not converge or violate a limit. */
+			int run();
+
+			chedata::PsatDataSet getOutageSystem(const ChePfContingency &ctg) const;
+
+			ChePfContingencyResult checkLimits(const chedata::PsatDataSet &sys, const CheState &st) const;
+
+			/** @brief Writes one line per contingency (base case first) as comma-separated values. */
+			bool writeSummary(const char *fileName) const;
+
+			ChePfContingencyAnalysis(const ChePfContingencyAnalysis &) = delete;
+
+			ChePfContingencyAnalysis &operator=(const ChePfContingencyAnalysis &) = delete;
+
+		private:
+			CheSparseSolver *makeOutageSolver() const;
+
+			ChePfContingencyResult solveContingency(int k, CheSparseSolver *&linSolver, CheSparseSolver *&genSolver);
+		};
+
+	} // namespace core
+} // namespace che
+
+#endif
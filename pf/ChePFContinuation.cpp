@@ -0,0 +1,137 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#include "pf/ChePFContinuation.h"
+#include "matio.h"
+
+namespace che {
+	namespace core {
+		static void writeMatVariable(mat_t *matfp, const char *name, const mat &data) {
+			mat x = data;
+			size_t dims[2] = {x.n_rows, x.n_cols};
+			matvar_t *matvar = Mat_VarCreate(name, MAT_C_DOUBLE, MAT_T_DOUBLE, 2, dims, x.memptr(), 0);
+			if (NULL == matvar) {
+				cerr << "Error creating variable for '" << name << "'." << endl;
+				return;
+			}
+			Mat_VarWrite(matfp, matvar, MAT_COMPRESSION_NONE);
+			Mat_VarFree(matvar);
+		}
+
+		ChePfContinuation::ChePfContinuation(const chedata::PsatDataSet &sys, const CheCompOptions &compOpt)
+			: calculator(sys, compOpt) {
+			maxScale = compOpt.maxAlpha;
+			minStep = 1e-3;
+			margin = 1.0;
+		}
+
+		void ChePfContinuation::setRecordStep(double step) {
+			if (step > 0.0 && maxScale > 1.0 + step) {
+				recordScales = regspace<vec>(1.0 + step, step, maxScale);
+			} else {
+				recordScales.reset();
+			}
+		}
+
+		void ChePfContinuation::scaleInjections(double scale) {
+			chedata::PsatDataSet &sys = calculator.baseSys;
+			if (sys.nPq > 0) {
+				chedata::PQ *pq = sys.mutable_pqs();
+				for (int i = 0; i < sys.nPq; i++) {
+					pq[i].P *= scale;
+					pq[i].Q *= scale;
+				}
+			}
+			if (sys.nPl > 0) {
+				chedata::Pl *pl = sys.mutable_pls();
+				for (int i = 0; i < sys.nPl; i++) {
+					pl[i].P *= scale;
+					pl[i].Q *= scale;
+				}
+			}
+			if (sys.nPv > 0) {
+				chedata::PV *pv = sys.mutable_pvs();
+				for (int i = 0; i < sys.nPv; i++) {
+					pv[i].P *= scale;
+				}
+			}
+			sys.invalidateInjections();
+		}
+
+		int ChePfContinuation::run() {
+			calculator.trajAlphas.reset();
+			int flag = calculator.calc();
+			CheState base = calculator.exportResult();
+			scales = vec(1).fill(1.0);
+			trajectory = mat(base.state);
+			margin = 1.0;
+			if (flag != 0) {
+				cerr << "Base case did not converge, no continuation." << endl;
+				return flag;
+			}
+			if (maxScale <= 1.0) {
+				return flag;
+			}
+
+			// lambda = 1 + alpha * range along the embedding from the base solution to the scaled injections
+			double range = maxScale - 1.0;
+			scaleInjections(maxScale);
+			calculator.resetStages();
+			calculator.setWarmStart(base);
+			calculator.minStep = minStep / range;
+			calculator.trajAlphas = (recordScales - 1.0) / range;
+			cout << "Continuation up to load scale " << maxScale << "." << endl;
+			calculator.calc();
+
+			margin = 1.0 + calculator.alphaReached * range;
+			int nRec = calculator.trajStates.n_cols;
+			if (nRec > 0) {
+				scales = join_cols(scales, 1.0 + calculator.trajAlphas.head(nRec) * range);
+				trajectory = join_rows(trajectory, calculator.trajStates);
+			}
+			if (margin > scales.tail(1)(0) + 1e-9) {
+				scales = join_cols(scales, vec(1).fill(margin));
+				trajectory = join_rows(trajectory, calculator.exportResult().state);
+			}
+			cout << "Loadability margin: load scale " << margin << (calculator.reachesMaxAlpha ? " (maxAlpha reached)." : ".") << endl;
+			return flag;
+		}
+
+		void ChePfContinuation::writeMatFile(const char *fileName) const {
+			mat_t *matfp = Mat_CreateVer(fileName, NULL, MAT_FT_DEFAULT);
+			if (NULL == matfp) {
+				cerr << "Error creating MAT file \"" << fileName << "\"." << endl;
+				return;
+			}
+			writeMatVariable(matfp, "s", trajectory.tail_cols(1));
+			writeMatVariable(matfp, "lambda", scales.t());
+			writeMatVariable(matfp, "traj", trajectory);
+			writeMatVariable(matfp, "margin", mat(1, 1).fill(margin));
+			Mat_Close(matfp);
+		}
+
+	} // namespace core
+} // namespace che
@@ -0,0 +1,77 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#ifndef _Che_ChePFContinuation_H_
+#define _Che_ChePFContinuation_H_
+
+#include "pf/ChePFCalculator.h"
+
+using namespace che::util;
+
+namespace che {
+	namespace core {
+		/**
+		 * @brief PV-curve continuation along the load-scaling direction up to compOpt.maxAlpha.
+		 *
+		 * The case is first solved at load scale 1. Then the constant-power injections (PQ loads, the P/Q part of
+		 * ZIP loads and the PV dispatch) are scaled by maxAlpha and the calculator is warm-started from the
+		 * solution at scale 1. This embeds the scale lambda = 1 + alpha * (maxAlpha - 1) while shunts, ZIP
+		 * current and impedance parts and voltage targets stay fixed. The walk stops at maxAlpha or when the
+		 * steps collapse at the nose, whose scale is reported as the loadability margin.
+		 */
+		class ChePfContinuation {
+		public:
+			ChePfCalculator calculator;
+			double maxScale;   // compOpt.maxAlpha of the input
+			vec recordScales;  // ascending load scales in (1, maxScale] to record
+			double minStep;	   // step length in lambda below which the walk counts as collapsed
+			vec scales;		   // recorded scales, starting with 1
+			mat trajectory;	   // states at scales, full layout
+			double margin;	   // largest load scale reached
+
+			ChePfContinuation(const chedata::PsatDataSet &sys, const CheCompOptions &compOpt);
+
+			/** @brief Records every step of the given length in lambda. */
+			void setRecordStep(double step);
+
+			/** @brief Solves the base case and walks the PV curve, returns the flag of the base case. */
+			int run();
+
+			/** @brief Writes 's' (state at the margin), 'lambda', 'traj' and 'margin' to a .mat file. */
+			void writeMatFile(const char *fileName) const;
+
+			ChePfContinuation(const ChePfContinuation &) = delete;
+
+			ChePfContinuation &operator=(const ChePfContinuation &) = delete;
+
+		private:
+			void scaleInjections(double scale);
+		};
+
+	} // namespace core
+} // namespace che
+
+#endif
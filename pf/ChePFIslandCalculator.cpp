@@ -0,0 +1,201 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#include "pf/ChePFIslandCalculator.h"
+#include "util/CheCompUtil.h"
+#include "util/CheThreadPool.h"
+#include <algorithm>
+#include <sstream>
+
+namespace che {
+	namespace core {
+		static vec getIslandPara(const vec &para, const uvec &synIdx, int nSyn) {
+			if (nSyn > 0 && para.n_rows == (uword)nSyn) {
+				return para(synIdx);
+			}
+			return para;
+		}
+
+		static void mergeBlock(vec &dst, const uvec &dstIdx, const uvec &sel, const vec &src, const uvec &srcIdx) {
+			if (sel.n_rows > 0 && srcIdx.n_rows == sel.n_rows) {
+				dst(dstIdx(sel)) = src(srcIdx);
+			}
+		}
+
+		ChePfIslandCalculator::ChePfIslandCalculator(const chedata::PsatDataSet &sys,
+													 const CheCompOptions &compOpt, const uvec &islands, int nThreads,
+													 const vec &ef, const vec &pm) : AbstractCheCalculator(sys, compOpt) {
+			this->paraEf = ef;
+			this->paraPm = pm;
+			this->nThreads = nThreads;
+			this->solverType = CHESPSOLVER_SUPERLU;
+			this->staleLuMaxIter = 0;
+			if (islands.n_rows != this->baseSys.nBus) {
+				this->islands = CheCompUtil::searchIslands(this->baseSys);
+			} else {
+				this->islands = islands;
+			}
+
+			int nIslands = this->islands.max() + 1;
+			uvec indIsland = baseSys.nInd > 0 ? uvec(this->islands(C_IDX(baseSys.get_inds_busNumber_vec()))) : uvec();
+			uvec synIsland = baseSys.nSyn > 0 ? uvec(this->islands(C_IDX(baseSys.get_syns_busNumber_vec()))) : uvec();
+			for (int i = 0; i < nIslands; i++) {
+				islandBusIdx.push_back(find(this->islands == i));
+				islandIndIdx.push_back(find(indIsland == i));
+				islandSynIdx.push_back(find(synIsland == i));
+			}
+			islandFlags.assign(nIslands, -1);
+
+			mergedState = CheState(baseSys);
+			mergedState.getBlock(mergedState.stateIdx->vrIdx).fill(1.0);
+			mergedState.getBlock(mergedState.stateIdx->mEfIdx).fill(1.0);
+		}
+
+		CheSingleEmbedSystem *ChePfIslandCalculator::getInitSystem(const chedata::PsatDataSet &sys) {
+			return new ChePfEmbedSystem(sys);
+		}
+
+		int ChePfIslandCalculator::calc() {
+			list<chedata::PsatDataSet> islandList = CheCompUtil::splitIslands(baseSys, islands);
+			std::vector<const chedata::PsatDataSet *> islandSets;
+			for (list<chedata::PsatDataSet>::const_iterator it = islandList.begin(); it != islandList.end(); it++) {
+				islandSets.push_back(&(*it));
+			}
+			int nIslands = islandSets.size();
+			std::vector<CheState> islandStates(nIslands);
+
+			// Largest islands first, so that a big island does not start last and dominate the wall time.
+			std::vector<int> order(nIslands);
+			for (int i = 0; i < nIslands; i++) {
+				order[i] = i;
+			}
+			std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+				return islandBusIdx[a].n_rows > islandBusIdx[b].n_rows;
+			});
+
+			int nWorkers = nThreads > 0 ? nThreads : CheThreadPool::getDefaultThreadCount();
+			if (nWorkers > nIslands) {
+				nWorkers = nIslands;
+			}
+			CheThreadPool pool(nWorkers);
+			for (int k = 0; k < nIslands; k++) {
+				int i = order[k];
+				pool.submit([this, i, &islandSets, &islandStates]() {
+					const chedata::PsatDataSet &islandSys = *islandSets[i];
+					ostringstream tag;
+					tag << "[Island " << i << "] ";
+					if (islandSys.nSw <= 0 && islandSys.nSyn <= 0) {
+						// No slack bus and no generator to share the mismatch: the island is de-energized.
+						islandFlags[i] = 0;
+						islandStates[i] = CheState(islandSys);
+						cout << tag.str() << "No slack bus or generator, treated as de-energized." << endl;
+						return;
+					}
+					try {
+						ChePfCalculator calculator(islandSys, compOpt, uvec(islandSys.nBus, fill::zeros),
+												   getIslandPara(paraEf, islandSynIdx[i], baseSys.nSyn),
+												   getIslandPara(paraPm, islandSynIdx[i], baseSys.nSyn));
+						calculator.logTag = tag.str();
+						calculator.solverType = solverType;
+						calculator.nSolverThreads = 1; // the islands already occupy the threads
+						if (staleLuMaxIter > 0) {
+							calculator.useStaleLu = true;
+							calculator.staleLuMaxIter = staleLuMaxIter;
+						}
+						islandFlags[i] = calculator.calc();
+						islandStates[i] = calculator.exportResult();
+					} catch (std::exception &e) {
+						islandFlags[i] = -1;
+						cerr << tag.str() << "Power flow failed: " << e.what() << endl;
+					}
+				});
+			}
+			pool.wait();
+
+			const CheStateIdx &gIdx = *mergedState.stateIdx;
+			int flag = 0;
+			for (int i = 0; i < nIslands; i++) {
+				if (islandFlags[i] != 0) {
+					flag = -1;
+				}
+				const vec &st = islandStates[i].state;
+				if (st.n_rows == 0) {
+					continue;
+				}
+				const CheStateIdx &lIdx = *islandStates[i].stateIdx;
+				const uvec &ib = islandBusIdx[i];
+				const uvec &ii = islandIndIdx[i];
+				const uvec &is = islandSynIdx[i];
+				mergeBlock(mergedState.state, gIdx.vrIdx, ib, st, lIdx.vrIdx);
+				mergeBlock(mergedState.state, gIdx.viIdx, ib, st, lIdx.viIdx);
+				mergeBlock(mergedState.state, gIdx.qIdx, ib, st, lIdx.qIdx);
+				mergeBlock(mergedState.state, gIdx.pIdx, ib, st, lIdx.pIdx);
+				mergeBlock(mergedState.state, gIdx.sIdx, ii, st, lIdx.sIdx);
+				mergeBlock(mergedState.state, gIdx.indEr1Idx, ii, st, lIdx.indEr1Idx);
+				mergeBlock(mergedState.state, gIdx.indEm1Idx, ii, st, lIdx.indEm1Idx);
+				mergeBlock(mergedState.state, gIdx.indEr2Idx, ii, st, lIdx.indEr2Idx);
+				mergeBlock(mergedState.state, gIdx.indEm2Idx, ii, st, lIdx.indEm2Idx);
+				mergeBlock(mergedState.state, gIdx.mDeltaIdx, is, st, lIdx.mDeltaIdx);
+				mergeBlock(mergedState.state, gIdx.mOmegaIdx, is, st, lIdx.mOmegaIdx);
+				mergeBlock(mergedState.state, gIdx.mEq1Idx, is, st, lIdx.mEq1Idx);
+				mergeBlock(mergedState.state, gIdx.mEq2Idx, is, st, lIdx.mEq2Idx);
+				mergeBlock(mergedState.state, gIdx.mEd1Idx, is, st, lIdx.mEd1Idx);
+				mergeBlock(mergedState.state, gIdx.mEd2Idx, is, st, lIdx.mEd2Idx);
+				mergeBlock(mergedState.state, gIdx.mPsidIdx, is, st, lIdx.mPsidIdx);
+				mergeBlock(mergedState.state, gIdx.mPsiqIdx, is, st, lIdx.mPsiqIdx);
+				mergeBlock(mergedState.state, gIdx.mPgIdx, is, st, lIdx.mPgIdx);
+				mergeBlock(mergedState.state, gIdx.mEfIdx, is, st, lIdx.mEfIdx);
+			}
+
+			cout << "Islands solved: " << nIslands << " on " << nWorkers << " threads." << endl;
+			this->reachesMaxAlpha = (flag == 0);
+			return flag;
+		}
+
+		CheState ChePfIslandCalculator::exportResult() {
+			return mergedState;
+		}
+
+		void ChePfIslandCalculator::writeMatFile(const char *fileName, double interval) {
+			this->writeMatFile(fileName);
+		}
+
+		void ChePfIslandCalculator::writeMatFile(const char *fileName) {
+			ChePfCalculator::writeStateMatFile(fileName, mergedState.state);
+		}
+
+		CheSingleEmbedSystem *ChePfIslandCalculator::getNewStage() {
+			return NULL;
+		}
+
+		CheSolution *ChePfIslandCalculator::getCheSolution() {
+			return NULL;
+		}
+
+		ChePfIslandCalculator::~ChePfIslandCalculator() {
+		}
+	} // namespace core
+} // namespace che
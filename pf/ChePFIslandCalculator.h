@@ -0,0 +1,82 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#ifndef _Che_ChePFIslandCalculator_H_
+#define _Che_ChePFIslandCalculator_H_
+
+#include "pf/ChePFCalculator.h"
+#include <vector>
+
+using namespace che::util;
+
+namespace che {
+	namespace core {
+		/**
+		 * @brief Island-parallel power flow.
+		 *
+		 * The case is split with CheCompUtil::splitIslands and every island is solved by its own
+		 * ChePfCalculator (own step control and factorization) on a thread pool. The island results are
+		 * merged back into the state layout of the original case.
+		 */
+		class ChePfIslandCalculator : public AbstractCheCalculator {
+		public:
+			vec paraEf;
+			vec paraPm;
+			uvec islands;
+			int nThreads;
+			int solverType; // CheSparseSolverType of the island calculators
+			int staleLuMaxIter; // > 0 enables the stale-LU mode of the island calculators
+			std::vector<uvec> islandBusIdx;
+			std::vector<uvec> islandIndIdx;
+			std::vector<uvec> islandSynIdx;
+			std::vector<int> islandFlags;
+			CheState mergedState;
+
+			ChePfIslandCalculator(const chedata::PsatDataSet &sys,
+								  const CheCompOptions &compOpt, const uvec &islands, int nThreads = 0,
+								  const vec &ef = vec(1).fill(1.2), const vec &pm = vec(1).fill(0.0));
+
+			virtual CheSingleEmbedSystem *getInitSystem(const chedata::PsatDataSet &sys);
+
+			virtual int calc();
+
+			virtual CheState exportResult();
+
+			virtual ~ChePfIslandCalculator();
+
+			virtual void writeMatFile(const char *);
+
+			virtual void writeMatFile(const char *, double);
+
+			virtual CheSingleEmbedSystem *getNewStage();
+
+			virtual CheSolution *getCheSolution();
+		};
+
+	} // namespace core
+} // namespace che
+
+#endif
@@ -0,0 +1,233 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#include "pf/ChePFLhsAssembler.h"
+#include <algorithm>
+
+namespace che {
+	namespace core {
+		ChePfLhsAssembler::ChePfLhsAssembler() : nPatternBuilds(0) {
+		}
+
+		static bool sameVec(const uvec &a, const uvec &b) {
+			return a.n_elem == b.n_elem && std::equal(a.begin(), a.end(), b.begin());
+		}
+
+		bool ChePfLhsAssembler::hasSamePattern(const uvec &lineFrom, const uvec &lineTo, const uvec &busType,
+												const uvec &genCols) const {
+			return sameVec(lineFrom, keyLineFrom) && sameVec(lineTo, keyLineTo) && sameVec(busType, keyBusType) &&
+				   sameVec(genCols, keyGenCols);
+		}
+
+		bool ChePfLhsAssembler::hasSameY(const sp_cx_mat &Y) const {
+			Y.sync();
+			return yColPtr.n_elem == Y.n_cols + 1 && yRowIdx.n_elem == Y.n_nonzero &&
+				   std::equal(Y.col_ptrs, Y.col_ptrs + Y.n_cols + 1, yColPtr.memptr()) &&
+				   std::equal(Y.row_indices, Y.row_indices + Y.n_nonzero, yRowIdx.memptr());
+		}
+
+		uword ChePfLhsAssembler::findSlot(uword row, uword col) const {
+			if (row >= lhs.n_rows || col >= lhs.n_cols) {
+				return lhs.n_nonzero;
+			}
+			const uword *first = lhs.row_indices + lhs.col_ptrs[col];
+			const uword *last = lhs.row_indices + lhs.col_ptrs[col + 1];
+			const uword *it = std::lower_bound(first, last, row);
+			// not in the pattern
+			if (it == last || *it != row) {
+				return lhs.n_nonzero + 1;
+			}
+			return it - lhs.row_indices;
+		}
+
+		void ChePfLhsAssembler::buildPattern(const sp_cx_mat &Y, const uvec &lineFrom, const uvec &lineTo,
+											  const uvec &busType, const uvec &genCols) {
+			Y.sync();
+			uword nbus = busType.n_elem;
+			uvec nonSw = find(busType != 2);
+			pvBus = find(busType == 1);
+			uword nNonSw = nonSw.n_elem;
+			uword npv = pvBus.n_elem;
+			uword n = 2 * nNonSw + npv;
+
+			// position of a bus among the non-slack buses, n for the slack buses
+			uvec pos(nbus);
+			pos.fill(n);
+			if (nNonSw > 0) {
+				pos(nonSw) = regspace<uvec>(0, nNonSw - 1);
+			}
+			stackPos = join_cols(pos, pos + nNonSw);
+			stackPos(find(stackPos >= n)).fill(n);
+
+			uword nLine = lineFrom.n_elem;
+			umat locations(2, 4 * Y.n_nonzero + 8 * nLine + 4 * nbus + genCols.n_elem * genCols.n_elem + 5 * npv);
+			uword m = 0;
+			auto add = [&](uword row, uword col) {
+				if (row < n && col < n) {
+					locations(0, m) = row;
+					locations(1, m) = col;
+					m++;
+				}
+			};
+			auto addBusPair = [&](uword i, uword j) {
+				add(stackPos(i), stackPos(j));
+				add(stackPos(i), stackPos(nbus + j));
+				add(stackPos(nbus + i), stackPos(j));
+				add(stackPos(nbus + i), stackPos(nbus + j));
+			};
+			// Y only has entries on the diagonal and between the terminals of a branch, the entries of Y
+			// itself are added as well in case it holds more
+			for (uword j = 0; j < Y.n_cols; j++) {
+				for (uword p = Y.col_ptrs[j]; p < Y.col_ptrs[j + 1]; p++) {
+					addBusPair(Y.row_indices[p], j);
+				}
+			}
+			for (uword l = 0; l < nLine; l++) {
+				addBusPair(lineFrom(l), lineTo(l));
+				addBusPair(lineTo(l), lineFrom(l));
+			}
+			for (uword i = 0; i < nbus; i++) {
+				addBusPair(i, i);
+			}
+			for (uword c = 0; c < genCols.n_elem; c++) {
+				for (uword r = 0; r < genCols.n_elem; r++) {
+					add(stackPos(genCols(r)), stackPos(genCols(c)));
+				}
+			}
+			for (uword k = 0; k < npv; k++) {
+				uword pvRow = 2 * nNonSw + k;
+				add(pvRow, stackPos(pvBus(k)));
+				add(pvRow, stackPos(nbus + pvBus(k)));
+				add(stackPos(pvBus(k)), pvRow);
+				add(stackPos(nbus + pvBus(k)), pvRow);
+				add(pvRow, pvRow);
+			}
+			lhs = sp_mat(true, locations.head_cols(m), vec(m, fill::ones), n, n, true, false);
+			values.zeros(lhs.n_nonzero + 1);
+
+			diagSlots.set_size(4, nbus);
+			for (uword i = 0; i < nbus; i++) {
+				diagSlots(0, i) = findSlot(stackPos(i), stackPos(i));
+				diagSlots(1, i) = findSlot(stackPos(i), stackPos(nbus + i));
+				diagSlots(2, i) = findSlot(stackPos(nbus + i), stackPos(i));
+				diagSlots(3, i) = findSlot(stackPos(nbus + i), stackPos(nbus + i));
+			}
+			genSlots.set_size(genCols.n_elem, genCols.n_elem);
+			for (uword c = 0; c < genCols.n_elem; c++) {
+				for (uword r = 0; r < genCols.n_elem; r++) {
+					genSlots(r, c) = findSlot(stackPos(genCols(r)), stackPos(genCols(c)));
+				}
+			}
+			pvSlots.set_size(5, npv);
+			for (uword k = 0; k < npv; k++) {
+				uword pvRow = 2 * nNonSw + k;
+				pvSlots(0, k) = findSlot(pvRow, stackPos(pvBus(k)));
+				pvSlots(1, k) = findSlot(pvRow, stackPos(nbus + pvBus(k)));
+				pvSlots(2, k) = findSlot(stackPos(pvBus(k)), pvRow);
+				pvSlots(3, k) = findSlot(stackPos(nbus + pvBus(k)), pvRow);
+				pvSlots(4, k) = findSlot(pvRow, pvRow);
+			}
+			mapY(Y);
+
+			keyLineFrom = lineFrom;
+			keyLineTo = lineTo;
+			keyBusType = busType;
+			keyGenCols = genCols;
+			nPatternBuilds++;
+		}
+
+		bool ChePfLhsAssembler::mapY(const sp_cx_mat &Y) {
+			Y.sync();
+			uword nbus = Y.n_cols;
+			ySlots.set_size(4, Y.n_nonzero);
+			for (uword j = 0; j < nbus; j++) {
+				for (uword p = Y.col_ptrs[j]; p < Y.col_ptrs[j + 1]; p++) {
+					uword i = Y.row_indices[p];
+					ySlots(0, p) = findSlot(stackPos(i), stackPos(j));
+					ySlots(1, p) = findSlot(stackPos(i), stackPos(nbus + j));
+					ySlots(2, p) = findSlot(stackPos(nbus + i), stackPos(j));
+					ySlots(3, p) = findSlot(stackPos(nbus + i), stackPos(nbus + j));
+				}
+			}
+			yColPtr = uvec(Y.col_ptrs, Y.n_cols + 1);
+			yRowIdx = uvec(Y.row_indices, Y.n_nonzero);
+			return ySlots.is_empty() || ySlots.max() <= lhs.n_nonzero;
+		}
+
+		const sp_mat &ChePfLhsAssembler::assemble(const sp_cx_mat &Y, const uvec &lineFrom, const uvec &lineTo, const uvec &busType,
+												  const mat &lhsDiag, const uvec &genCols, const mat &genLhs,
+												  const vec &C0, const vec &D0, const vec &E0, const vec &F0, const uvec &ipvClamped) {
+			if (!hasSamePattern(lineFrom, lineTo, busType, genCols)) {
+				buildPattern(Y, lineFrom, lineTo, busType, genCols);
+			} else if (!hasSameY(Y) && !mapY(Y)) {
+				// Y has entries outside the pattern of the branch list
+				buildPattern(Y, lineFrom, lineTo, busType, genCols);
+			}
+			values.zeros();
+			double *val = values.memptr();
+
+			// voltage blocks [-G B; -B -G] plus the diagonal terms
+			for (uword p = 0; p < Y.n_nonzero; p++) {
+				double g = Y.values[p].real();
+				double b = Y.values[p].imag();
+				val[ySlots(0, p)] -= g;
+				val[ySlots(1, p)] += b;
+				val[ySlots(2, p)] -= b;
+				val[ySlots(3, p)] -= g;
+			}
+			for (uword k = 0; k < 4; k++) {
+				for (uword i = 0; i < lhsDiag.n_rows; i++) {
+					val[diagSlots(k, i)] += lhsDiag(i, k);
+				}
+			}
+			for (uword c = 0; c < genLhs.n_cols; c++) {
+				for (uword r = 0; r < genLhs.n_rows; r++) {
+					val[genSlots(r, c)] += genLhs(r, c);
+				}
+			}
+			// PV buses: Q columns and voltage magnitude rows
+			for (uword k = 0; k < pvBus.n_elem; k++) {
+				uword b = pvBus(k);
+				val[pvSlots(0, k)] = C0(b);
+				val[pvSlots(1, k)] = D0(b);
+				val[pvSlots(2, k)] = -F0(b);
+				val[pvSlots(3, k)] = -E0(b);
+			}
+			for (uword k = 0; k < ipvClamped.n_elem; k++) {
+				val[pvSlots(0, ipvClamped(k))] = 0.0;
+				val[pvSlots(1, ipvClamped(k))] = 0.0;
+				val[pvSlots(4, ipvClamped(k))] = 1.0;
+			}
+
+			arrayops::copy(access::rwp(lhs.values), val, lhs.n_nonzero);
+			return lhs;
+		}
+
+		const sp_mat &ChePfLhsAssembler::getMatrix() const {
+			return lhs;
+		}
+	} // namespace core
+} // namespace che
@@ -0,0 +1,101 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#ifndef _Che_ChePFLhsAssembler_H_
+#define _Che_ChePFLhsAssembler_H_
+
+#include "util/SafeArmadillo.h"
+
+using namespace arma;
+using namespace std;
+
+namespace che {
+	namespace core {
+		/**
+		 * @brief Assembles the level-0 PF matrix LHS_mat directly in CSC form.
+		 *
+		 * The rows and columns are [real(V); imag(V)] of the non-slack buses followed by Q of the PV buses.
+		 * The sparsity pattern is built from the branch list (in or out of service), the bus types and the
+		 * generator buses, so it is built once per network and every stage only rewrites the value array in
+		 * place. A branch outage only changes the map from the entries of Y to the pattern. Entries that may
+		 * vanish numerically (an outaged branch, D0 = 0 at the flat start, a PV row held at a Q limit) are
+		 * kept as structural zeros, so the pattern, and with it the symbolic analysis of the linear solver,
+		 * stays the same across stages and outages.
+		 */
+		class ChePfLhsAssembler {
+		public:
+			int nPatternBuilds;
+
+			ChePfLhsAssembler();
+
+			/**
+			 * @brief Returns LHS_mat of a stage.
+			 *
+			 * lineFrom/lineTo are the 0-based terminal buses of all branches. lhsDiag (nBus x 4) is added to the
+			 * diagonals of the four voltage blocks, genLhs (|genCols|^2) to the rows and columns genCols of the
+			 * stacked [real; imag] bus indices. ipvClamped lists the PV rows (in the order of the PV buses) whose
+			 * voltage equation is replaced by dQ = 0.
+			 */
+			const sp_mat &assemble(const sp_cx_mat &Y, const uvec &lineFrom, const uvec &lineTo, const uvec &busType,
+								   const mat &lhsDiag, const uvec &genCols, const mat &genLhs,
+								   const vec &C0, const vec &D0, const vec &E0, const vec &F0, const uvec &ipvClamped);
+
+			/** @brief LHS_mat of the last assemble(). */
+			const sp_mat &getMatrix() const;
+
+		private:
+			bool hasSamePattern(const uvec &lineFrom, const uvec &lineTo, const uvec &busType, const uvec &genCols) const;
+
+			bool hasSameY(const sp_cx_mat &Y) const;
+
+			void buildPattern(const sp_cx_mat &Y, const uvec &lineFrom, const uvec &lineTo, const uvec &busType, const uvec &genCols);
+
+			bool mapY(const sp_cx_mat &Y);
+
+			uword findSlot(uword row, uword col) const;
+
+			// key of the current pattern
+			uvec keyLineFrom;
+			uvec keyLineTo;
+			uvec keyBusType;
+			uvec keyGenCols;
+			// pattern of Y that ySlots maps
+			uvec yColPtr;
+			uvec yRowIdx;
+
+			sp_mat lhs;
+			vec values;		// one more than lhs.n_nonzero, the last slot takes the entries of the slack buses
+			uvec stackPos;	// row/column of LHS_mat of a stacked bus index, lhs.n_rows for the slack buses
+			umat ySlots;	// 4 x nnz(Y), slots of -G, B, -B, -G
+			umat diagSlots; // 4 x nBus
+			umat genSlots;	// |genCols| x |genCols|
+			umat pvSlots;	// 5 x nPv, slots of C0, D0, -F0, -E0 and of the Q diagonal
+			uvec pvBus;
+		};
+	} // namespace core
+} // namespace che
+
+#endif
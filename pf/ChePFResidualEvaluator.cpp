@@ -0,0 +1,223 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#include "pf/ChePFResidualEvaluator.h"
+#include <cmath>
+
+namespace che {
+	namespace core {
+		ChePfResidualEvaluator::ChePfResidualEvaluator() {
+			nBus = 0;
+			warm = false;
+		}
+
+		ChePfResidualEvaluator::ChePfResidualEvaluator(const chedata::PsatDataSet &sys, const shared_ptr<const CheYMatrix> &yMatrix, const CheStateIdx &stateIdx) {
+			nBus = sys.nBus;
+			vrIdx = stateIdx.vrIdx;
+			viIdx = stateIdx.viIdx;
+			qIdx = stateIdx.qIdx;
+			sIdx = stateIdx.sIdx;
+			mDeltaIdx = stateIdx.mDeltaIdx;
+			mEfIdx = stateIdx.mEfIdx;
+
+			this->yMatrix = yMatrix;
+			YshAlpha = yMatrix->Ysh;
+			pUnit = vec(nBus, fill::zeros);
+			qUnit = vec(nBus, fill::zeros);
+
+			// Indexed updates accumulate over repeated buses, as the element-wise updates of the original formulation do.
+			uvec shuntBus = C_IDX(sys.get_shunts_busNumber_vec());
+			vec shuntG = sys.get_shunts_g_vec();
+			vec shuntB = sys.get_shunts_b_vec();
+			for (uword i = 0; i < shuntBus.n_rows; i++) {
+				YshAlpha(shuntBus(i)) += cx_double(shuntG(i), shuntB(i));
+			}
+
+			uvec pqBus = C_IDX(sys.get_pqs_busNumber_vec());
+			vec pqP = sys.get_pqs_P_vec();
+			vec pqQ = sys.get_pqs_Q_vec();
+			for (uword i = 0; i < pqBus.n_rows; i++) {
+				pUnit(pqBus(i)) -= pqP(i);
+				qUnit(pqBus(i)) -= pqQ(i);
+			}
+
+			pvBus = C_IDX(sys.get_pvs_busNumber_vec());
+			vec pvP = sys.get_pvs_P_vec();
+			for (uword i = 0; i < pvBus.n_rows; i++) {
+				pUnit(pvBus(i)) += pvP(i);
+			}
+			vec pvVMag = sys.get_pvs_vMag_vec();
+			pvVMag2 = pvVMag % pvVMag;
+			pvActive = vec(pvBus.n_rows, fill::ones);
+
+			warm = false;
+			pBase = vec(nBus, fill::zeros);
+			qBase = vec(nBus, fill::zeros);
+			pvVMag2Base = vec(pvBus.n_rows, fill::ones);
+
+			uvec busType(nBus, fill::zeros);
+			busType(pvBus).fill(1);
+			busType(C_IDX(sys.get_sws_busNumber_vec())).fill(2);
+			swBus = find(busType == 2);
+
+			if (sys.nPl > 0) {
+				plsBus = C_IDX(sys.get_pls_busNumber_vec());
+				vec plsStatus = conv_to<vec>::from(sys.get_pls_status_vec());
+				vec plsP = sys.get_pls_P_vec();
+				vec plsQ = sys.get_pls_Q_vec();
+				vec plsG = sys.get_pls_g_vec();
+				vec plsB = sys.get_pls_b_vec();
+				for (uword i = 0; i < plsBus.n_rows; i++) {
+					pUnit(plsBus(i)) -= plsP(i) * plsStatus(i);
+					qUnit(plsBus(i)) -= plsQ(i) * plsStatus(i);
+					YshAlpha(plsBus(i)) += cx_double(plsG(i), plsB(i));
+				}
+				plsI = cx_vec(sys.get_pls_Ip_vec(), -sys.get_pls_Iq_vec()) % plsStatus;
+			}
+
+			if (sys.nSyn > 0) {
+				synBus = C_IDX(sys.get_syns_busNumber_vec());
+				synRs = sys.get_syns_ra_vec();
+				synXq = sys.get_syns_xq_vec();
+				synXd = sys.get_syns_xd_vec();
+				synDen = synRs % synRs + synXq % synXd;
+			}
+
+			if (sys.nInd > 0) {
+				indBus = C_IDX(sys.get_inds_busNumber_vec());
+				indR1 = sys.get_inds_rs_vec();
+				indX1 = sys.get_inds_xs_vec();
+				indXm = sys.get_inds_xm_vec();
+				indR2 = sys.get_inds_rr1_vec();
+				indX2 = sys.get_inds_xr1_vec();
+				indT0 = sys.get_inds_Ta_vec() + sys.get_inds_Tb_vec() + sys.get_inds_Tc_vec();
+				indT1 = -sys.get_inds_Tb_vec() - 2 * sys.get_inds_Tc_vec();
+				indT2 = sys.get_inds_Tc_vec();
+			}
+		}
+
+		void ChePfResidualEvaluator::setWarmBase(const vec &solVal) {
+			// With the parameters at their full value, the injections that make solVal an exact solution are the
+			// ones of the set plus the power mismatch of solVal.
+			warm = false;
+			pBase.zeros();
+			qBase.zeros();
+			pvVMag2Base.ones();
+			vec res = evaluate(solVal, 1.0);
+			pBase = pUnit + res.rows(0, nBus - 1);
+			qBase = qUnit + res.rows(nBus, 2 * nBus - 1);
+			cx_vec V(solVal.rows(vrIdx(0), vrIdx(nBus - 1)), solVal.rows(viIdx(0), viIdx(nBus - 1)));
+			pvVMag2Base = square(abs(V(pvBus)));
+			warm = true;
+		}
+
+		void ChePfResidualEvaluator::setQClamp(const vec &qClamp) {
+			for (uword i = 0; i < pvBus.n_rows; i++) {
+				pvActive(i) = std::isfinite(qClamp(pvBus(i))) ? 0.0 : 1.0;
+			}
+		}
+
+		vec ChePfResidualEvaluator::evaluate(const vec &solVal, double absA) const {
+			return evaluateBatch(solVal, vec(1).fill(absA));
+		}
+
+		mat ChePfResidualEvaluator::evaluateBatch(const mat &solVals, const vec &absAlphas) const {
+			uword nPv = pvBus.n_rows;
+			uword nInd = indBus.n_rows;
+			uword nAlpha = absAlphas.n_rows;
+			// vr and vi are contiguous blocks of the state layout
+			cx_mat V = cx_mat(solVals.rows(vrIdx(0), vrIdx(nBus - 1)), solVals.rows(viIdx(0), viIdx(nBus - 1)));
+
+			// network term of all alphas in one sparse x dense-block product
+			cx_mat IInj = yMatrix->Ytr * V;
+			mat res(2 * nBus + nPv + nInd, nAlpha);
+			cx_vec SInjRHS(nBus);
+			for (uword j = 0; j < nAlpha; j++) {
+				double absA = absAlphas(j);
+				double parA = warm ? 1.0 : absA; // scale of the non-injection parameters
+				const double *solVal = solVals.colptr(j);
+				const cx_double *v = V.colptr(j);
+				cx_double *iInj = IInj.colptr(j);
+				double *r = res.colptr(j);
+
+				for (int k = 0; k < nBus; k++) {
+					iInj[k] += parA * YshAlpha(k) * v[k];
+				}
+				for (uword i = 0; i < plsBus.n_rows; i++) {
+					uword b = plsBus(i);
+					iInj[b] += parA * plsI(i) * v[b] / abs(v[b]);
+				}
+				for (int k = 0; k < nBus; k++) {
+					SInjRHS(k) = v[k] * conj(iInj[k]);
+				}
+
+				for (uword i = 0; i < synBus.n_rows; i++) {
+					uword b = synBus(i);
+					double efq = solVal[mEfIdx(i)];
+					double cosd = cos(solVal[mDeltaIdx(i)]);
+					double sind = sin(solVal[mDeltaIdx(i)]);
+					double cm = v[b].real();
+					double dm = v[b].imag();
+					double vd = sind * cm - cosd * dm;
+					double vq = cosd * cm + sind * dm;
+					double id = (-synRs(i) * vd + synXq(i) * (efq - vq)) / synDen(i);
+					double iq = (synXd(i) * vd + synRs(i) * (efq - vq)) / synDen(i);
+					cx_double ig(sind * id + cosd * iq, -cosd * id + sind * iq);
+					SInjRHS(b) -= v[b] * conj(ig);
+				}
+
+				for (uword i = 0; i < nInd; i++) {
+					uword b = indBus(i);
+					double s = solVal[sIdx(i)];
+					cx_double z1(indR1(i), indX1(i));
+					cx_double ym(0 / indXm(i), -parA / indXm(i));
+					cx_double y2 = s / cx_double(indR2(i), s * indX2(i));
+					cx_double ytotal = (ym + y2) / (z1 * (ym + y2) + 1.0);
+					cx_double iL = v[b] * ytotal;
+					SInjRHS(b) += v[b] * conj(iL);
+
+					cx_double iRs = (v[b] - iL * z1) * y2;
+					r[2 * nBus + nPv + i] = std::norm(iRs) * indR2(i) - parA * (indT0(i) + s * (indT1(i) + s * indT2(i))) * s;
+				}
+
+				for (int k = 0; k < nBus; k++) {
+					SInjRHS(k) -= cx_double(pBase(k) + absA * (pUnit(k) - pBase(k)), qBase(k) + absA * (qUnit(k) - qBase(k)) + solVal[qIdx(k)]);
+				}
+				for (uword i = 0; i < swBus.n_rows; i++) {
+					SInjRHS(swBus(i)) = 0.;
+				}
+				for (int k = 0; k < nBus; k++) {
+					r[k] = SInjRHS(k).real();
+					r[nBus + k] = SInjRHS(k).imag();
+				}
+				for (uword i = 0; i < nPv; i++) {
+					r[2 * nBus + i] = pvActive(i) * (pvVMag2Base(i) + absA * (pvVMag2(i) - pvVMag2Base(i)) - std::norm(v[pvBus(i)]));
+				}
+			}
+			return res;
+		}
+	} // namespace core
+} // namespace che
@@ -0,0 +1,116 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#ifndef _Che_ChePFResidualEvaluator_H_
+#define _Che_ChePFResidualEvaluator_H_
+
+#include "util/CheState.h"
+#include "util/CheYMatrix.h"
+#include "io/CheDataFormat.h"
+#include <memory>
+
+using namespace che::util;
+using namespace che::io;
+using namespace arma;
+using namespace std;
+
+namespace che {
+	namespace core {
+		/**
+		 * @brief Residual of the power flow equations, with the alpha-independent data precomputed.
+		 *
+		 * Built once per ChePfEmbedSystem. It holds the bus/component index vectors, the network
+		 * admittance and the per-unit load and shunt terms. evaluate() then only takes one SpMV and
+		 * the component terms for a given state and absolute alpha.
+		 */
+		class ChePfResidualEvaluator {
+		public:
+			int nBus;
+			// state positions
+			uvec vrIdx;
+			uvec viIdx;
+			uvec qIdx;
+			uvec sIdx;
+			uvec mDeltaIdx;
+			uvec mEfIdx;
+			// network, Y(alpha) = yMatrix->Ytr + alpha * diag(YshAlpha)
+			shared_ptr<const CheYMatrix> yMatrix;
+			cx_vec YshAlpha;
+			// injections per unit alpha
+			vec pUnit;
+			vec qUnit;
+			uvec swBus;
+			// ZIP loads, constant-current part per unit alpha
+			uvec plsBus;
+			cx_vec plsI;
+			// PV
+			uvec pvBus;
+			vec pvVMag2;
+			vec pvActive; // 0 for PV entries whose reactive power is clamped at a limit (voltage not enforced)
+			// warm start: the injections and PV targets move from the base values (pBase, qBase, pvVMag2Base) to
+			// the ones of the set, every other parameter stays at its full value. A flat start has pBase = qBase = 0
+			// and pvVMag2Base = 1.
+			bool warm;
+			vec pBase;
+			vec qBase;
+			vec pvVMag2Base;
+			// syn
+			uvec synBus;
+			vec synRs;
+			vec synXq;
+			vec synXd;
+			vec synDen;
+			// ind (single-cage)
+			uvec indBus;
+			vec indR1;
+			vec indX1;
+			vec indXm;
+			vec indR2;
+			vec indX2;
+			vec indT0;
+			vec indT1;
+			vec indT2;
+
+			ChePfResidualEvaluator();
+
+			ChePfResidualEvaluator(const chedata::PsatDataSet &sys, const shared_ptr<const CheYMatrix> &yMatrix, const CheStateIdx &stateIdx);
+
+			/** @brief Embeds the difference to the converged state solVal of a nearby operating point (warm start). */
+			void setWarmBase(const vec &solVal);
+
+			/** @brief Drops the voltage residual of the PV buses with a finite entry in qClamp (per bus). */
+			void setQClamp(const vec &qClamp);
+
+			/** @brief Residual [real(dS); imag(dS); dV(PV); dT(ind)] at the state solVal and absolute alpha absA. */
+			vec evaluate(const vec &solVal, double absA) const;
+
+			/** @brief Residuals of several states (columns of solVals) at the matching absolute alphas. */
+			mat evaluateBatch(const mat &solVals, const vec &absAlphas) const;
+		};
+	} // namespace core
+} // namespace che
+
+#endif
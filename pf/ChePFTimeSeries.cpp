@@ -0,0 +1,254 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#include "pf/ChePFTimeSeries.h"
+#include "matio.h"
+#include "nvwa/pctimer.h"
+
+namespace che {
+	namespace core {
+		/**
+		 * @brief Appends state columns to variable 's' (and the flags to 'flag') of a MAT 7.3 file.
+		 *
+		 * Without HDF5 support in matio the columns are kept in memory and written when the stream is closed.
+		 */
+		class ChePfStateMatStream {
+		public:
+			ChePfStateMatStream(const char *fileName) : fileName(fileName) {
+				matfp = Mat_CreateVer(fileName, NULL, MAT_FT_MAT73);
+				streaming = matfp != NULL;
+			}
+
+			~ChePfStateMatStream() {
+				close();
+			}
+
+			void append(const vec &state, int flag) {
+				if (!streaming) {
+					buffer.insert_cols(buffer.n_cols, state);
+					flagBuffer.insert_cols(flagBuffer.n_cols, rowvec(1).fill(flag));
+					return;
+				}
+				vec col = state;
+				size_t dims[2] = {col.n_rows, 1};
+				writeAppend("s", dims, col.memptr());
+				double flagVal = flag;
+				size_t flagDims[2] = {1, 1};
+				writeAppend("flag", flagDims, &flagVal);
+			}
+
+			void close() {
+				if (streaming) {
+					if (matfp != NULL) {
+						Mat_Close(matfp);
+						matfp = NULL;
+					}
+					return;
+				}
+				if (buffer.n_cols == 0) {
+					return;
+				}
+				matfp = Mat_CreateVer(fileName.c_str(), NULL, MAT_FT_DEFAULT);
+				if (NULL == matfp) {
+					cerr << "Error creating MAT file \"" << fileName << "\"." << endl;
+				} else {
+					size_t dims[2] = {buffer.n_rows, buffer.n_cols};
+					writeVar("s", dims, buffer.memptr());
+					size_t flagDims[2] = {1, flagBuffer.n_cols};
+					writeVar("flag", flagDims, flagBuffer.memptr());
+					Mat_Close(matfp);
+					matfp = NULL;
+				}
+				buffer.reset();
+				flagBuffer.reset();
+			}
+
+			ChePfStateMatStream(const ChePfStateMatStream &) = delete;
+
+			ChePfStateMatStream &operator=(const ChePfStateMatStream &) = delete;
+
+		private:
+			string fileName;
+			mat_t *matfp;
+			bool streaming;
+			mat buffer;
+			rowvec flagBuffer;
+
+			void writeAppend(const char *name, size_t *dims, double *data) {
+				matvar_t *matvar = Mat_VarCreate(name, MAT_C_DOUBLE, MAT_T_DOUBLE, 2, dims, data, MAT_F_DONT_COPY_DATA);
+				if (NULL == matvar) {
+					cerr << "Error creating variable for '" << name << "'." << endl;
+					return;
+				}
+				if (Mat_VarWriteAppend(matfp, matvar, MAT_COMPRESSION_NONE, 2) != 0) {
+					cerr << "Error appending to variable '" << name << "' of \"" << fileName << "\"." << endl;
+				}
+				Mat_VarFree(matvar);
+			}
+
+			void writeVar(const char *name, size_t *dims, double *data) {
+				matvar_t *matvar = Mat_VarCreate(name, MAT_C_DOUBLE, MAT_T_DOUBLE, 2, dims, data, 0);
+				if (NULL == matvar) {
+					cerr << "Error creating variable for '" << name << "'." << endl;
+					return;
+				}
+				Mat_VarWrite(matfp, matvar, MAT_COMPRESSION_NONE);
+				Mat_VarFree(matvar);
+			}
+		};
+
+		static bool readMatVariable(mat_t *matfp, const char *name, mat &data) {
+			matvar_t *matvar = Mat_VarRead(matfp, name);
+			if (matvar == NULL) {
+				return false;
+			}
+			bool ok = matvar->class_type == MAT_C_DOUBLE && matvar->rank == 2;
+			if (ok) {
+				data = mat((double *)matvar->data, matvar->dims[0], matvar->dims[1]);
+			} else {
+				cerr << "Variable '" << name << "' should be a real matrix." << endl;
+			}
+			Mat_VarFree(matvar);
+			return ok;
+		}
+
+		static vec scaleColumn(const mat &scale, int k, int n) {
+			if (scale.n_rows == 1) {
+				return vec(n > 0 ? n : 0).fill(scale(0, k));
+			}
+			return scale.col(k);
+		}
+
+		ChePfTimeSeries::ChePfTimeSeries(const chedata::PsatDataSet &sys, const CheCompOptions &compOpt, const uvec &islands)
+			: calculator(sys, compOpt, islands) {
+			chainWarmStart = false;
+			totalTime = 0.0;
+			const chedata::PsatDataSet &baseSys = calculator.baseSys;
+			pqP0 = baseSys.nPq > 0 ? baseSys.get_pqs_P_vec() : vec();
+			pqQ0 = baseSys.nPq > 0 ? baseSys.get_pqs_Q_vec() : vec();
+			pvP0 = baseSys.nPv > 0 ? baseSys.get_pvs_P_vec() : vec();
+		}
+
+		bool ChePfTimeSeries::readProfileMatFile(const char *fileName) {
+			mat_t *matfp = Mat_Open(fileName, MAT_ACC_RDONLY);
+			if (NULL == matfp) {
+				cerr << "Error opening MAT file \"" << fileName << "\"." << endl;
+				return false;
+			}
+			mat pq;
+			mat pv;
+			bool ok = readMatVariable(matfp, "pq", pq);
+			if (!ok) {
+				cerr << "No load profile 'pq' in \"" << fileName << "\"." << endl;
+			}
+			if (ok && !readMatVariable(matfp, "pv", pv)) {
+				pv.reset();
+			}
+			Mat_Close(matfp);
+			if (!ok) {
+				return false;
+			}
+
+			int nPq = calculator.baseSys.nPq > 0 ? calculator.baseSys.nPq : 0;
+			int nPv = calculator.baseSys.nPv > 0 ? calculator.baseSys.nPv : 0;
+			if (pq.n_rows != 1 && pq.n_rows != (uword)nPq) {
+				cerr << "Load profile 'pq' has " << pq.n_rows << " rows, expected 1 or " << nPq << "." << endl;
+				return false;
+			}
+			if (!pv.is_empty() && pv.n_rows != 1 && pv.n_rows != (uword)nPv) {
+				cerr << "Generation profile 'pv' has " << pv.n_rows << " rows, expected 1 or " << nPv << "." << endl;
+				return false;
+			}
+			if (!pv.is_empty() && pv.n_cols != pq.n_cols) {
+				cerr << "Profiles 'pq' (" << pq.n_cols << " points) and 'pv' (" << pv.n_cols << " points) differ in length." << endl;
+				return false;
+			}
+			pqScale = pq;
+			pvScale = pv;
+			return true;
+		}
+
+		int ChePfTimeSeries::nPoints() const {
+			return pqScale.n_cols;
+		}
+
+		void ChePfTimeSeries::applyPoint(int k) {
+			chedata::PsatDataSet &sys = calculator.baseSys;
+			if (sys.nPq > 0) {
+				vec m = scaleColumn(pqScale, k, sys.nPq);
+				chedata::PQ *pq = sys.mutable_pqs();
+				for (int i = 0; i < sys.nPq; i++) {
+					pq[i].P = pqP0(i) * m(i);
+					pq[i].Q = pqQ0(i) * m(i);
+				}
+			}
+			if (sys.nPv > 0 && !pvScale.is_empty()) {
+				vec m = scaleColumn(pvScale, k, sys.nPv);
+				chedata::PV *pv = sys.mutable_pvs();
+				for (int i = 0; i < sys.nPv; i++) {
+					pv[i].P = pvP0(i) * m(i);
+				}
+			}
+			// the lines are untouched, the Y matrix of the network stays valid
+			sys.invalidateInjections();
+		}
+
+		int ChePfTimeSeries::run(const char *fileName) {
+			int n = nPoints();
+			int nFailed = 0;
+			flags.assign(n, -1);
+			totalTime = 0.0;
+			ChePfStateMatStream stream(fileName);
+			for (int k = 0; k < n; k++) {
+				applyPoint(k);
+				calculator.resetStages();
+				pctimer_t stTime = pctimer();
+				int flag = calculator.calc();
+				pctimer_t endTime = pctimer();
+				totalTime += endTime - stTime;
+
+				CheState st = calculator.exportResult();
+				stream.append(st.state, flag);
+				flags[k] = flag;
+				if (flag != 0) {
+					nFailed++;
+				}
+				if (chainWarmStart) {
+					if (flag == 0) {
+						calculator.setWarmStart(st);
+					} else {
+						calculator.warmState = CheState();
+					}
+				}
+				cout << "Point " << k + 1 << "/" << n << (flag == 0 ? " converged" : " did not converge") << " in "
+					 << endTime - stTime << " s." << endl;
+			}
+			stream.close();
+			return nFailed;
+		}
+
+	} // namespace core
+} // namespace che
@@ -0,0 +1,88 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#ifndef _Che_ChePFTimeSeries_H_
+#define _Che_ChePFTimeSeries_H_
+
+#include "pf/ChePFCalculator.h"
+#include <vector>
+
+using namespace che::util;
+
+namespace che {
+	namespace core {
+		/**
+		 * @brief Quasi-static time-series power flow.
+		 *
+		 * One ChePfCalculator solves every point of a load/generation profile in sequence. Only the PQ loads and
+		 * the PV dispatch of its baseSys change between points, so the renumbering, the Y matrix, the state
+		 * layout and the symbolic factorization of the linear solvers are set up once for the whole series.
+		 * The state of each point is appended to the output file as soon as it is solved.
+		 */
+		class ChePfTimeSeries {
+		public:
+			ChePfCalculator calculator;
+			mat pqScale;		// multipliers of the PQ loads, one column per point, 1 or nPq rows
+			mat pvScale;		// multipliers of the PV dispatch, one column per point, 1 or nPv rows, may be empty
+			bool chainWarmStart; // warm-start every point from the previous converged point
+			std::vector<int> flags;
+			double totalTime;
+
+			ChePfTimeSeries(const chedata::PsatDataSet &sys, const CheCompOptions &compOpt, const uvec &islands);
+
+			/**
+			 * @brief Reads the profiles from the variables 'pq' and (optional) 'pv' of a .mat file.
+			 *
+			 * Each column is a point. A single row scales all loads (or generators) alike.
+			 */
+			bool readProfileMatFile(const char *fileName);
+
+			int nPoints() const;
+
+			/** @brief Sets the injections of point k in the calculator's baseSys. */
+			void applyPoint(int k);
+
+			/**
+			 * @brief Solves all points and streams the states into the columns of variable 's' of fileName.
+			 *
+			 * The flag of each point goes to variable 'flag'. Returns the number of points that did not converge.
+			 */
+			int run(const char *fileName);
+
+			ChePfTimeSeries(const ChePfTimeSeries &) = delete;
+
+			ChePfTimeSeries &operator=(const ChePfTimeSeries &) = delete;
+
+		private:
+			vec pqP0;
+			vec pqQ0;
+			vec pvP0;
+		};
+
+	} // namespace core
+} // namespace che
+
+#endif
@@ -29,6 +29,7 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <map>
 #include "matio.h"
 #include <json/json.h>
 
@@ -1032,6 +1033,15 @@ namespace che {
 			sp_mat LHSY = LHStotal.tail_cols(nY);
 			sp_mat LHSX = LHStotal.head_cols(nX);
 
+			// LHSY is constant within the segment, factorize it once for the calibration and all levels.
+			unique_ptr<CheSparseSolver> linSolver;
+			if (nAE > 0) {
+				linSolver.reset(CheSparseSolverFactory::makeSolver(options.linearSolver, options.nSolverThreads));
+				if (!linSolver->factor(LHSY)) {
+					throw std::runtime_error("solveSegment(): factorization of the algebraic Jacobian failed");
+				}
+			}
+
 			if (nAE > 0) {
 				// Check and calibrate AE imbalances.
 				vec diff = calcDiff(sasSol->solution, 0.0);
@@ -1042,7 +1052,9 @@ namespace che {
 					int iter = 0;
 					int maxIter = 10;
 					while (diffMax > tol / 10 && iter < maxIter) {
-						sasSol->solution->solution.col(0).tail(nY) -= spsolve(LHSY, diffAE);
+						vec dy;
+						linSolver->solve(dy, diffAE);
+						sasSol->solution->solution.col(0).tail(nY) -= dy;
 						diff = calcDiff(sasSol->solution, 0.0);
 						diffAE = diff.tail(nAE);
 						diffMax = norm(diffAE, "inf");
@@ -1068,7 +1080,9 @@ namespace che {
 
 					rhs -= LHSX * sasSol->solution->solution.col(lvl).head(nX);
 
-					sasSol->solution->solution.col(lvl).tail(nY) = spsolve(LHSY, rhs, "superlu");
+					vec y;
+					linSolver->solve(y, rhs);
+					sasSol->solution->solution.col(lvl).tail(nY) = y;
 				}
 			}
 
@@ -1183,19 +1197,17 @@ namespace che {
 			return nullptr;
 		}
 
-		void SasSolutionSet::writeMatFile(const char *fileName, double interval) {
-			if (solutionLink.empty()) {
-				return;
-			}
+		mat SasSolutionSet::sampleSolutions(double interval, vector<double> &tVec) {
 			double t = 0.0;
 			double maxAlpha = solutionLink.back()->absEnd;
-			vector<vec> vecVec;
-			vector<double> tVec;
+			vector<SasSolution *> colSol;
+			vector<double> colAlpha;
 			while (t <= maxAlpha - interval / 100) {
 				list<shared_ptr<SasSolution>> foundSolution = findSasSolution(t);
 				list<shared_ptr<SasSolution>>::iterator sasIt;
 				for (sasIt = foundSolution.begin(); sasIt != foundSolution.end(); sasIt++) {
-					vecVec.push_back((*sasIt)->solution->getSolValue(t - (*sasIt)->absStart));
+					colSol.push_back(sasIt->get());
+					colAlpha.push_back(t - (*sasIt)->absStart);
 					tVec.push_back(t);
 				}
 				t += interval;
@@ -1203,10 +1215,33 @@ namespace che {
 					t = maxAlpha;
 				}
 			}
-			mat solutionMat(vecVec[0].n_rows, vecVec.size(), fill::zeros);
-			for (int i = 0; i < vecVec.size(); i++) {
-				solutionMat.col(i) = vecVec[i];
+			if (colSol.empty()) {
+				return mat();
+			}
+
+			// Every segment is evaluated at all of its sample points in one batched call.
+			mat solutionMat(colSol[0]->solution->nState, colSol.size(), fill::zeros);
+			map<SasSolution *, vector<uword>> colsOfSol;
+			for (uword i = 0; i < colSol.size(); i++) {
+				colsOfSol[colSol[i]].push_back(i);
+			}
+			for (auto &it : colsOfSol) {
+				uvec cols = conv_to<uvec>::from(it.second);
+				vec alphas(cols.n_rows);
+				for (uword i = 0; i < cols.n_rows; i++) {
+					alphas(i) = colAlpha[cols(i)];
+				}
+				solutionMat.cols(cols) = it.first->solution->getSolValues(alphas);
+			}
+			return solutionMat;
+		}
+
+		void SasSolutionSet::writeMatFile(const char *fileName, double interval) {
+			if (solutionLink.empty()) {
+				return;
 			}
+			vector<double> tVec;
+			mat solutionMat = sampleSolutions(interval, tVec);
 
 			vector<int> iVarVec;
 			// WARNING: Not rigorous, only use the CompModel of the last solution
@@ -1256,26 +1291,8 @@ namespace che {
 			if (solutionLink.empty()) {
 				return;
 			}
-			double t = 0.0;
-			double maxAlpha = solutionLink.back()->absEnd;
-			vector<vec> vecVec;
 			vector<double> tVec;
-			while (t <= maxAlpha - interval / 100) {
-				list<shared_ptr<SasSolution>> foundSolution = findSasSolution(t);
-				list<shared_ptr<SasSolution>>::iterator sasIt;
-				for (sasIt = foundSolution.begin(); sasIt != foundSolution.end(); sasIt++) {
-					vecVec.push_back((*sasIt)->solution->getSolValue(t - (*sasIt)->absStart));
-					tVec.push_back(t);
-				}
-				t += interval;
-				if (t > maxAlpha) {
-					t = maxAlpha;
-				}
-			}
-			mat solutionMat(vecVec[1].n_rows, vecVec.size(), fill::zeros);
-			for (int i = 0; i < vecVec.size(); i++) {
-				solutionMat.col(i) = vecVec[i];
-			}
+			mat solutionMat = sampleSolutions(interval, tVec);
 			vec tMat = conv_to<vec>::from(tVec);
 
 			Json::Value res;
@@ -33,6 +33,7 @@
 #include <list>
 #include <vector>
 #include "util/AbstractCheCalculator.h"
+#include "util/CheSparseSolver.h"
 
 namespace che {
 	namespace core {
@@ -53,6 +54,8 @@ namespace che {
 			double alphaTol = 1e-4;
 			double errorTol = 1e-6;
 			int nLvl = 15;
+			int linearSolver = CHESPSOLVER_SUPERLU; // CheSparseSolverType of the AE Jacobian
+			int nSolverThreads = 0;
 		};
 
 		class SasSolution {
@@ -82,6 +85,10 @@ namespace che {
 			void writeJSONFile(const char *fileName, double interval);
 
 			virtual ~SasSolutionSet();
+
+		private:
+			/** @brief Samples all segments every interval, one column per sample; the sample times go to tVec. */
+			mat sampleSolutions(double interval, std::vector<double> &tVec);
 		};
 
 		class SasComputationModel {
@@ -26,6 +26,7 @@
 //
 #include "util/AbstractCheCalculator.h"
 #include "util/CheCompUtil.h"
+#include "util/CheToeplitzSolver.h"
 
 using namespace che::util;
 using namespace che::io;
@@ -40,65 +41,14 @@ namespace che {
 			return sol;
 		}
 
-		static mat solveToepLU(const mat &ct, const mat &y) {
-			int d = ct.n_rows;
-			int n = y.n_cols;
-
-			mat x(d, n, fill::zeros);
-
-			for (int i = 0; i < d; i++) {
-				mat toep(n, n);
-				for (int j = -n + 1; j < n; j++) {
-					toep.diag(j).fill(ct(i, n - 1 - j));
-				}
-				// toep.print("toep:");
-				try {
-					x.row(i) = solve(toep, y.row(i).t(), solve_opts::no_approx).t();
-				} catch (const std::runtime_error &e) {
-					x.row(i).fill(datum::nan);
-				}
-			}
-			return x;
-		}
-
-		static mat solveToepLevinson(const mat &ct, const mat &y) {
-			int d = ct.n_rows;
-			int n = y.n_cols;
-
-			mat f(d, n, fill::zeros);
-			mat b(d, n, fill::zeros);
-			mat temp(d, n, fill::zeros);
-			mat x(d, n, fill::zeros);
-			vec epsf(d);
-			vec epsb(d);
-			vec epsx(d);
-			vec alphaf(d);
-			vec betaf(d);
-			vec alphab(d);
-			vec betab(d);
-
-			f.col(0) = ones<vec>(d) / ct.col(n - 1);
-			b.col(n - 1) = f.col(0);
-			x.col(0) = y.col(0) % f.col(0);
-
-			for (int i = 1; i < n; i++) {
-				epsf = sum(f.cols(0, i - 1) % fliplr(ct.cols(n, n + i - 1)), 1);
-				epsb = sum(b.cols(n - i, n - 1) % fliplr(ct.cols(n - i - 1, n - 2)), 1);
-				epsx = sum(x.cols(0, i - 1) % fliplr(ct.cols(n, n + i - 1)), 1);
-
-				alphaf = ones<vec>(d) / (ones<vec>(d) - epsf % epsb);
-				betaf = -epsf % alphaf;
-				alphab = -epsb % alphaf;
-				betab = alphaf;
-
-				temp.cols(0, i - 1) = f.cols(0, i - 1);
-				f.cols(0, i) = temp.cols(0, i).each_col() % alphaf + b.cols(n - i - 1, n - 1).each_col() % betaf;
-				b.cols(n - i - 1, n - 1) = temp.cols(0, i).each_col() % alphab + b.cols(n - i - 1, n - 1).each_col() % betab;
-
-				x.cols(0, i) += b.cols(n - i - 1, n - 1).each_col() % (y.col(i) - epsx);
+		static mat getPowerSeriesValues(const mat &coeff, const vec &alphas) {
+			mat sol = repmat(coeff.col(coeff.n_cols - 1), 1, alphas.n_rows);
+			rowvec alphaRow = alphas.t();
+			for (int i = coeff.n_cols - 2; i >= 0; i--) {
+				sol.each_row() %= alphaRow;
+				sol.each_col() += coeff.col(i);
 			}
-
-			return x;
+			return sol;
 		}
 
 		CheCompOptions::CheCompOptions(int nLvl, double maxAlpha, double alphaTol, double segLen, double diffTol, double diffTolMax) {
@@ -116,6 +66,14 @@ namespace che {
 			this->nLvl = nLvl;
 		}
 
+		mat CheSolution::getSolValues(const vec &alphas) {
+			mat sol(nState, alphas.n_rows);
+			for (uword i = 0; i < alphas.n_rows; i++) {
+				sol.col(i) = getSolValue(alphas(i));
+			}
+			return sol;
+		}
+
 		CheSolution::~CheSolution() {}
 
 		CheSolutionPowerSeries::CheSolutionPowerSeries(int nState, int nLvl) : CheSolution(nState, nLvl) {
@@ -126,6 +84,10 @@ namespace che {
 			return getPowerSeriesValue(solution, alpha);
 		}
 
+		mat CheSolutionPowerSeries::getSolValues(const vec &alphas) {
+			return getPowerSeriesValues(solution, alphas);
+		}
+
 		CheSolutionPowerSeries::~CheSolutionPowerSeries() {}
 
 		CheSolutionPade::CheSolutionPade(int nState, int num, int den, PadeSolverType sol) : CheSolution(nState, num + den) {
@@ -133,13 +95,15 @@ namespace che {
 			this->den = den;
 			ready = false;
 			solver = sol;
+			hornerDeg = 0;
+			nThreads = 0;
 			this->type = CHESOL_PADE;
 		}
 
 		CheSolutionPade::CheSolutionPade(int nState, int nLvl, PadeSolverType sol)
 			: CheSolutionPade(nState, nLvl - nLvl / 2, nLvl / 2, sol) {}
 
-		vec CheSolutionPade::getSolValue(double alpha) {
+		void CheSolutionPade::prepareCoeff() {
 			if (!ready) {
 				if (solver == PADE_LEVINSON) {
 					ready = genPadeCoeffLevinson();
@@ -147,16 +111,97 @@ namespace che {
 					ready = genPadeCoeffLU();
 				}
 			}
+			if (ready && hornerCoeff.is_empty()) {
+				buildHornerTable();
+			}
+		}
+
+		void CheSolutionPade::buildHornerTable() {
+			int nNum = numerator.n_cols;
+			int nDen = denomenator.n_cols + 1;
+			hornerDeg = (nNum > nDen ? nNum : nDen) - 1;
+			hornerCoeff.zeros(nState, 2 * (hornerDeg + 1));
+			for (int k = 0; k < nNum; k++) {
+				hornerCoeff.col(2 * k) = numerator.col(k);
+			}
+			hornerCoeff.col(1).fill(1.0);
+			for (int k = 1; k < nDen; k++) {
+				hornerCoeff.col(2 * k + 1) = denomenator.col(k - 1);
+			}
+		}
+
+		void CheSolutionPade::evalHorner(const double *alphas, int nAlpha, double *out) {
+			int n = nState;
+			if (denWork.n_rows != n || denWork.n_cols < nAlpha) {
+				denWork.set_size(n, nAlpha);
+			}
+			for (int j = 0; j < nAlpha; j++) {
+				const double *cN = hornerCoeff.colptr(2 * hornerDeg);
+				const double *cD = hornerCoeff.colptr(2 * hornerDeg + 1);
+				double *pN = out + (size_t)j * n;
+				double *pD = denWork.colptr(j);
+				for (int i = 0; i < n; i++) {
+					pN[i] = cN[i];
+					pD[i] = cD[i];
+				}
+			}
+			// the power loop is outermost so that every coefficient column is read once for all alphas
+			for (int k = hornerDeg - 1; k >= 0; k--) {
+				const double *cN = hornerCoeff.colptr(2 * k);
+				const double *cD = hornerCoeff.colptr(2 * k + 1);
+				for (int j = 0; j < nAlpha; j++) {
+					double a = alphas[j];
+					double *pN = out + (size_t)j * n;
+					double *pD = denWork.colptr(j);
+					for (int i = 0; i < n; i++) {
+						pN[i] = pN[i] * a + cN[i];
+						pD[i] = pD[i] * a + cD[i];
+					}
+				}
+			}
+			bool allFinite = true;
+			for (int j = 0; j < nAlpha; j++) {
+				double *pN = out + (size_t)j * n;
+				const double *pD = denWork.colptr(j);
+				for (int i = 0; i < n; i++) {
+					pN[i] /= pD[i];
+				}
+				for (int i = 0; i < n && allFinite; i++) {
+					allFinite = std::isfinite(pN[i]);
+				}
+			}
+			if (allFinite) {
+				return;
+			}
+			// A state that is non-finite at any alpha falls back to its power series for good.
+			mat sol(out, n, nAlpha, false, true);
+			uvec nfIdx = find_nonfinite(sol);
+			uvec nfrows = unique(nfIdx - (nfIdx / n) * n);
+			vec alphaVec(const_cast<double *>(alphas), nAlpha, false, true);
+			sol.rows(nfrows) = getPowerSeriesValues(solution.rows(nfrows), alphaVec);
+			numerator.rows(nfrows) = solution.submat(nfrows, regspace<uvec>(0, this->num - 1));
+			denomenator.rows(nfrows).fill(0.0);
+			buildHornerTable();
+		}
+
+		vec CheSolutionPade::getSolValue(double alpha) {
+			prepareCoeff();
 			if (!ready) {
 				return getPowerSeriesValue(solution, alpha);
 			} else {
-				vec sol = getPowerSeriesValue(numerator, alpha) / getPowerSeriesValue(join_rows(ones<mat>(denomenator.n_rows, 1), denomenator), alpha);
-				uvec nfrows = find_nonfinite(sol);
-				if (!nfrows.is_empty()) {
-					sol.rows(nfrows) = getPowerSeriesValue(solution.rows(nfrows), alpha);
-					numerator.rows(nfrows) = solution.submat(nfrows, regspace<uvec>(0, this->num - 1));
-					denomenator.rows(nfrows).fill(0.0);
-				}
+				vec sol(nState);
+				evalHorner(&alpha, 1, sol.memptr());
+				return sol;
+			}
+		}
+
+		mat CheSolutionPade::getSolValues(const vec &alphas) {
+			prepareCoeff();
+			if (!ready) {
+				return getPowerSeriesValues(solution, alphas);
+			} else {
+				mat sol(nState, alphas.n_rows);
+				evalHorner(alphas.memptr(), alphas.n_rows, sol.memptr());
 				return sol;
 			}
 		}
@@ -167,7 +212,7 @@ namespace che {
 			mat ttxc = augTc.cols(augTc.n_cols - nT - 1, augTc.n_cols - 2);
 			mat ytxc = augTc.tail_cols(den);
 
-			this->denomenator = solveToepLU(ttxc, ytxc);
+			CheToeplitzSolver::solve(ttxc, ytxc, this->denomenator, CHETOEP_DENSE, nThreads);
 			this->numerator = augTc.cols(den, num + den - 1);
 
 			for (int i = 0; i < den; i++) {
@@ -182,7 +227,8 @@ namespace che {
 			mat ttxc = augTc.cols(augTc.n_cols - nT - 1, augTc.n_cols - 2);
 			mat ytxc = augTc.tail_cols(den);
 
-			this->denomenator = -solveToepLevinson(ttxc, ytxc);
+			CheToeplitzSolver::solve(ttxc, ytxc, this->denomenator, CHETOEP_LEVINSON, nThreads);
+			this->denomenator = -this->denomenator;
 			this->numerator = augTc.cols(den, num + den - 1);
 
 			/*cout.precision(16);
@@ -203,7 +249,19 @@ namespace che {
 		CheSingleEmbedSystem::CheSingleEmbedSystem(const CheState &init, const chedata::PsatDataSet &baseSys, double startAlpha = 0)
 			: initState(init), baseSys(baseSys) {
 			this->startAlpha = startAlpha;
-			yMatrix = CheCompUtil::getCheYMatrix(baseSys);
+			yMatrix = CheCompUtil::getSharedYMatrix(baseSys);
+		}
+
+		mat CheSingleEmbedSystem::calcEqBalances(CheSolution *sol, const vec &alphas) {
+			mat diff;
+			for (uword i = 0; i < alphas.n_rows; i++) {
+				vec d = calcEqBalance(sol, alphas(i));
+				if (i == 0) {
+					diff.set_size(d.n_rows, alphas.n_rows);
+				}
+				diff.col(i) = d;
+			}
+			return diff;
 		}
 
 		CheSolution *CheSolutionFactory::makeInitCheSol(int type, int nState, int nLvl) {
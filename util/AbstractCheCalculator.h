@@ -72,6 +72,9 @@ namespace che {
 
 			virtual vec getSolValue(double alpha) = 0;
 
+			/** @brief Values at several alphas, one column per entry of alphas. */
+			virtual mat getSolValues(const vec &alphas);
+
 			virtual ~CheSolution();
 
 			CheSolution(const CheSolution &) = delete;
@@ -85,6 +88,8 @@ namespace che {
 
 			virtual vec getSolValue(double alpha);
 
+			virtual mat getSolValues(const vec &alphas);
+
 			virtual ~CheSolutionPowerSeries();
 		};
 
@@ -96,6 +101,7 @@ namespace che {
 			mat denomenator;
 			bool ready;
 			PadeSolverType solver;
+			int nThreads; // threads of the coefficient generation, 0 for all hardware threads
 
 			CheSolutionPade(int nState, int num, int den, PadeSolverType sol = PADE_LEVINSON);
 
@@ -103,9 +109,24 @@ namespace che {
 
 			virtual vec getSolValue(double alpha);
 
+			virtual mat getSolValues(const vec &alphas);
+
 			virtual ~CheSolutionPade();
 
 		private:
+			// Fused Horner table of numerator and denominator: column 2k holds the numerator and column 2k+1
+			// the denominator coefficients of power k, so that both polynomials are evaluated in one pass
+			// over contiguous columns. Built lazily from numerator/denomenator.
+			mat hornerCoeff;
+			int hornerDeg;
+			mat denWork; // denominator values of the last evaluation, reused across calls
+
+			void prepareCoeff();
+
+			void buildHornerTable();
+
+			void evalHorner(const double *alphas, int nAlpha, double *out);
+
 			bool genPadeCoeffLU();
 
 			bool genPadeCoeffLevinson();
@@ -123,7 +144,7 @@ namespace che {
 			CheState initState;
 			chedata::PsatDataSet baseSys;
 			double startAlpha;
-			CheYMatrix yMatrix;
+			shared_ptr<const CheYMatrix> yMatrix; // shared by all stages of the same network
 
 			CheSingleEmbedSystem(const CheState &, const chedata::PsatDataSet &, double);
 
@@ -131,6 +152,9 @@ namespace che {
 
 			virtual vec calcEqBalance(CheSolution *sol, double alpha) = 0;
 
+			/** @brief Mismatches at several alphas, one column per entry of alphas. */
+			virtual mat calcEqBalances(CheSolution *sol, const vec &alphas);
+
 			virtual CheSingleEmbedSystem *getNewEmbeddedSystem(const CheState &st, double alpha) = 0;
 
 			CheSingleEmbedSystem(const CheSingleEmbedSystem &) = delete;
@@ -25,12 +25,19 @@
 // ***************************************************************************************************
 //
 #include "CheCompUtil.h"
+#include <map>
+#include <mutex>
 
 using namespace arma;
 using namespace std;
 
 namespace che {
 	namespace util {
+		static std::mutex stateIdxMutex;
+		static map<vector<int>, shared_ptr<const CheStateIdx>> stateIdxCache;
+		static std::mutex yMatrixMutex;
+		static map<long, weak_ptr<const CheYMatrix>> yMatrixCache;
+
 		static int nchoosek(int n, int k) {
 			if (n >= 0 && k >= 0 && k <= n) {
 				if (n == 0) {
@@ -122,8 +129,8 @@ namespace che {
 			return seq;
 		}
 
-		static uvec generateIdx(int &sCount, int num) {
-			if (num > 0) {
+		static uvec generateIdx(int &sCount, int used, int num) {
+			if (used && num > 0) {
 				int start = sCount;
 				int end = sCount + num - 1;
 				sCount += num;
@@ -133,34 +140,7 @@ namespace che {
 			}
 		}
 
-		CheStateIdx CheCompUtil::getCheStateIdx(const chedata::PsatDataSet &cheData) {
-			CheStateIdx stateIdx = CheStateIdx();
-			int sCount = 0;
-			stateIdx.vrIdx = generateIdx(sCount, cheData.nBus);
-			stateIdx.viIdx = generateIdx(sCount, cheData.nBus);
-			stateIdx.qIdx = generateIdx(sCount, cheData.nBus);
-			stateIdx.pIdx = generateIdx(sCount, cheData.nBus);
-
-			stateIdx.sIdx = generateIdx(sCount, cheData.nInd);
-			stateIdx.indEr1Idx = generateIdx(sCount, cheData.nInd);
-			stateIdx.indEm1Idx = generateIdx(sCount, cheData.nInd);
-			stateIdx.indEr2Idx = generateIdx(sCount, cheData.nInd);
-			stateIdx.indEm2Idx = generateIdx(sCount, cheData.nInd);
-
-			stateIdx.mDeltaIdx = generateIdx(sCount, cheData.nSyn);
-			stateIdx.mOmegaIdx = generateIdx(sCount, cheData.nSyn);
-			stateIdx.mEq1Idx = generateIdx(sCount, cheData.nSyn);
-			stateIdx.mEq2Idx = generateIdx(sCount, cheData.nSyn);
-			stateIdx.mEd1Idx = generateIdx(sCount, cheData.nSyn);
-			stateIdx.mEd2Idx = generateIdx(sCount, cheData.nSyn);
-			stateIdx.mPsidIdx = generateIdx(sCount, cheData.nSyn);
-			stateIdx.mPsiqIdx = generateIdx(sCount, cheData.nSyn);
-			stateIdx.mPgIdx = generateIdx(sCount, cheData.nSyn);
-			stateIdx.mEfIdx = generateIdx(sCount, cheData.nSyn);
-
-			int nExc1 = 0;
-			int nExc2 = 0;
-			int nExc3 = 0;
+		static void countSubTypes(const chedata::PsatDataSet &cheData, int &nExc1, int &nExc2, int &nExc3, int &nTg1, int &nTg2) {
 			if (cheData.nExc > 0) {
 				uvec excType = cheData.get_excs_excType_vec();
 				uvec exc1Idx = find(excType == 1);
@@ -170,25 +150,6 @@ namespace che {
 				nExc2 = exc2Idx.n_rows;
 				nExc3 = exc3Idx.n_rows;
 			}
-			stateIdx.avr1mIdx = generateIdx(sCount, nExc1);
-			stateIdx.avr1r1Idx = generateIdx(sCount, nExc1);
-			stateIdx.avr1r2Idx = generateIdx(sCount, nExc1);
-			stateIdx.avr1rIdx = generateIdx(sCount, nExc1);
-			stateIdx.avr1fIdx = generateIdx(sCount, nExc1);
-
-			stateIdx.avr2mIdx = generateIdx(sCount, nExc2);
-			stateIdx.avr2r1Idx = generateIdx(sCount, nExc2);
-			stateIdx.avr2rIdx = generateIdx(sCount, nExc2);
-			stateIdx.avr2r2Idx = generateIdx(sCount, nExc2);
-			stateIdx.avr2fIdx = generateIdx(sCount, nExc2);
-
-			stateIdx.avrmIdx = generateIdx(sCount, nExc3);
-			stateIdx.avrrIdx = generateIdx(sCount, nExc3);
-			stateIdx.avrfIdx = generateIdx(sCount, nExc3);
-			stateIdx.avrrefIdx = generateIdx(sCount, nExc3);
-
-			int nTg1 = 0;
-			int nTg2 = 0;
 			if (cheData.nTg > 0) {
 				uvec tgType = cheData.get_tgs_tgType_vec();
 				uvec tg1Idx = find(tgType == 1);
@@ -196,25 +157,149 @@ namespace che {
 				nTg1 = tg1Idx.n_rows;
 				nTg2 = tg2Idx.n_rows;
 			}
-			stateIdx.tg1inIndx = generateIdx(sCount, nTg1);
-			stateIdx.tg11Idx = generateIdx(sCount, nTg1);
-			stateIdx.tg12Idx = generateIdx(sCount, nTg1);
-			stateIdx.tg13Idx = generateIdx(sCount, nTg1);
+		}
 
-			stateIdx.tg2gIdx = generateIdx(sCount, nTg2);
-			stateIdx.tg2mIdx = generateIdx(sCount, nTg2);
+		shared_ptr<const CheStateIdx> CheCompUtil::getSharedStateIdx(const chedata::PsatDataSet &cheData, int blocks) {
+			// The layout only depends on the component counts, so datasets with equal counts share one descriptor.
+			int nExc1 = 0;
+			int nExc2 = 0;
+			int nExc3 = 0;
+			int nTg1 = 0;
+			int nTg2 = 0;
+			countSubTypes(cheData, nExc1, nExc2, nExc3, nTg1, nTg2);
+			vector<int> key = {blocks, cheData.nBus, cheData.nInd, cheData.nSyn, nExc1, nExc2, nExc3, nTg1, nTg2, cheData.nTg};
 
-			stateIdx.tmechIdx = generateIdx(sCount, cheData.nTg);
+			std::lock_guard<std::mutex> lock(stateIdxMutex);
+			map<vector<int>, shared_ptr<const CheStateIdx>>::iterator itr = stateIdxCache.find(key);
+			if (itr != stateIdxCache.end()) {
+				return itr->second;
+			}
+			shared_ptr<const CheStateIdx> stateIdx(new CheStateIdx(getCheStateIdx(cheData, blocks)));
+			stateIdxCache.insert(make_pair(key, stateIdx));
+			return stateIdx;
+		}
 
-			stateIdx.fIdx = generateIdx(sCount, cheData.nBus);
-			stateIdx.qpltIdx = generateIdx(sCount, cheData.nBus);
-			stateIdx.vgIdx = generateIdx(sCount, cheData.nBus);
+		CheStateIdx CheCompUtil::getCheStateIdx(const chedata::PsatDataSet &cheData, int blocks) {
+			CheStateIdx stateIdx = CheStateIdx();
+			int sCount = 0;
+			stateIdx.vrIdx = generateIdx(sCount, blocks & CHESTATE_V, cheData.nBus);
+			stateIdx.viIdx = generateIdx(sCount, blocks & CHESTATE_V, cheData.nBus);
+			stateIdx.qIdx = generateIdx(sCount, blocks & CHESTATE_Q, cheData.nBus);
+			stateIdx.pIdx = generateIdx(sCount, blocks & CHESTATE_P, cheData.nBus);
+
+			stateIdx.sIdx = generateIdx(sCount, blocks & CHESTATE_IND_SLIP, cheData.nInd);
+			stateIdx.indEr1Idx = generateIdx(sCount, blocks & CHESTATE_IND_EMF, cheData.nInd);
+			stateIdx.indEm1Idx = generateIdx(sCount, blocks & CHESTATE_IND_EMF, cheData.nInd);
+			stateIdx.indEr2Idx = generateIdx(sCount, blocks & CHESTATE_IND_EMF, cheData.nInd);
+			stateIdx.indEm2Idx = generateIdx(sCount, blocks & CHESTATE_IND_EMF, cheData.nInd);
+
+			stateIdx.mDeltaIdx = generateIdx(sCount, blocks & CHESTATE_SYN_DELTA, cheData.nSyn);
+			stateIdx.mOmegaIdx = generateIdx(sCount, blocks & CHESTATE_SYN_OMEGA, cheData.nSyn);
+			stateIdx.mEq1Idx = generateIdx(sCount, blocks & CHESTATE_SYN_FLUX, cheData.nSyn);
+			stateIdx.mEq2Idx = generateIdx(sCount, blocks & CHESTATE_SYN_FLUX, cheData.nSyn);
+			stateIdx.mEd1Idx = generateIdx(sCount, blocks & CHESTATE_SYN_FLUX, cheData.nSyn);
+			stateIdx.mEd2Idx = generateIdx(sCount, blocks & CHESTATE_SYN_FLUX, cheData.nSyn);
+			stateIdx.mPsidIdx = generateIdx(sCount, blocks & CHESTATE_SYN_FLUX, cheData.nSyn);
+			stateIdx.mPsiqIdx = generateIdx(sCount, blocks & CHESTATE_SYN_FLUX, cheData.nSyn);
+			stateIdx.mPgIdx = generateIdx(sCount, blocks & CHESTATE_SYN_PG, cheData.nSyn);
+			stateIdx.mEfIdx = generateIdx(sCount, blocks & CHESTATE_SYN_EF, cheData.nSyn);
+
+			int nExc1 = 0;
+			int nExc2 = 0;
+			int nExc3 = 0;
+			int nTg1 = 0;
+			int nTg2 = 0;
+			countSubTypes(cheData, nExc1, nExc2, nExc3, nTg1, nTg2);
+			stateIdx.avr1mIdx = generateIdx(sCount, blocks & CHESTATE_EXC, nExc1);
+			stateIdx.avr1r1Idx = generateIdx(sCount, blocks & CHESTATE_EXC, nExc1);
+			stateIdx.avr1r2Idx = generateIdx(sCount, blocks & CHESTATE_EXC, nExc1);
+			stateIdx.avr1rIdx = generateIdx(sCount, blocks & CHESTATE_EXC, nExc1);
+			stateIdx.avr1fIdx = generateIdx(sCount, blocks & CHESTATE_EXC, nExc1);
+
+			stateIdx.avr2mIdx = generateIdx(sCount, blocks & CHESTATE_EXC, nExc2);
+			stateIdx.avr2r1Idx = generateIdx(sCount, blocks & CHESTATE_EXC, nExc2);
+			stateIdx.avr2rIdx = generateIdx(sCount, blocks & CHESTATE_EXC, nExc2);
+			stateIdx.avr2r2Idx = generateIdx(sCount, blocks & CHESTATE_EXC, nExc2);
+			stateIdx.avr2fIdx = generateIdx(sCount, blocks & CHESTATE_EXC, nExc2);
+
+			stateIdx.avrmIdx = generateIdx(sCount, blocks & CHESTATE_EXC, nExc3);
+			stateIdx.avrrIdx = generateIdx(sCount, blocks & CHESTATE_EXC, nExc3);
+			stateIdx.avrfIdx = generateIdx(sCount, blocks & CHESTATE_EXC, nExc3);
+			stateIdx.avrrefIdx = generateIdx(sCount, blocks & CHESTATE_EXC, nExc3);
+
+			stateIdx.tg1inIndx = generateIdx(sCount, blocks & CHESTATE_TG, nTg1);
+			stateIdx.tg11Idx = generateIdx(sCount, blocks & CHESTATE_TG, nTg1);
+			stateIdx.tg12Idx = generateIdx(sCount, blocks & CHESTATE_TG, nTg1);
+			stateIdx.tg13Idx = generateIdx(sCount, blocks & CHESTATE_TG, nTg1);
+
+			stateIdx.tg2gIdx = generateIdx(sCount, blocks & CHESTATE_TG, nTg2);
+			stateIdx.tg2mIdx = generateIdx(sCount, blocks & CHESTATE_TG, nTg2);
+
+			stateIdx.tmechIdx = generateIdx(sCount, blocks & CHESTATE_TG, cheData.nTg);
+
+			stateIdx.fIdx = generateIdx(sCount, blocks & CHESTATE_AGC, cheData.nBus);
+			stateIdx.qpltIdx = generateIdx(sCount, blocks & CHESTATE_AGC, cheData.nBus);
+			stateIdx.vgIdx = generateIdx(sCount, blocks & CHESTATE_AGC, cheData.nBus);
 
 			stateIdx.nState = sCount;
 
 			return stateIdx;
 		}
 
+		static void mapBlock(vec &dst, const uvec &dstIdx, const vec &src, const uvec &srcIdx) {
+			if (dstIdx.n_rows > 0 && dstIdx.n_rows == srcIdx.n_rows) {
+				dst(dstIdx) = src(srcIdx);
+			}
+		}
+
+		vec CheCompUtil::mapState(const vec &state, const CheStateIdx &from, const CheStateIdx &to) {
+			vec res(to.nState, fill::zeros);
+			mapBlock(res, to.vrIdx, state, from.vrIdx);
+			mapBlock(res, to.viIdx, state, from.viIdx);
+			mapBlock(res, to.qIdx, state, from.qIdx);
+			mapBlock(res, to.pIdx, state, from.pIdx);
+			mapBlock(res, to.sIdx, state, from.sIdx);
+			mapBlock(res, to.indEr1Idx, state, from.indEr1Idx);
+			mapBlock(res, to.indEm1Idx, state, from.indEm1Idx);
+			mapBlock(res, to.indEr2Idx, state, from.indEr2Idx);
+			mapBlock(res, to.indEm2Idx, state, from.indEm2Idx);
+			mapBlock(res, to.mDeltaIdx, state, from.mDeltaIdx);
+			mapBlock(res, to.mOmegaIdx, state, from.mOmegaIdx);
+			mapBlock(res, to.mEq1Idx, state, from.mEq1Idx);
+			mapBlock(res, to.mEq2Idx, state, from.mEq2Idx);
+			mapBlock(res, to.mEd1Idx, state, from.mEd1Idx);
+			mapBlock(res, to.mEd2Idx, state, from.mEd2Idx);
+			mapBlock(res, to.mPsidIdx, state, from.mPsidIdx);
+			mapBlock(res, to.mPsiqIdx, state, from.mPsiqIdx);
+			mapBlock(res, to.mPgIdx, state, from.mPgIdx);
+			mapBlock(res, to.mEfIdx, state, from.mEfIdx);
+			mapBlock(res, to.avr1mIdx, state, from.avr1mIdx);
+			mapBlock(res, to.avr1r1Idx, state, from.avr1r1Idx);
+			mapBlock(res, to.avr1r2Idx, state, from.avr1r2Idx);
+			mapBlock(res, to.avr1rIdx, state, from.avr1rIdx);
+			mapBlock(res, to.avr1fIdx, state, from.avr1fIdx);
+			mapBlock(res, to.avr2mIdx, state, from.avr2mIdx);
+			mapBlock(res, to.avr2r1Idx, state, from.avr2r1Idx);
+			mapBlock(res, to.avr2rIdx, state, from.avr2rIdx);
+			mapBlock(res, to.avr2r2Idx, state, from.avr2r2Idx);
+			mapBlock(res, to.avr2fIdx, state, from.avr2fIdx);
+			mapBlock(res, to.avrmIdx, state, from.avrmIdx);
+			mapBlock(res, to.avrrIdx, state, from.avrrIdx);
+			mapBlock(res, to.avrfIdx, state, from.avrfIdx);
+			mapBlock(res, to.avrrefIdx, state, from.avrrefIdx);
+			mapBlock(res, to.tg1inIndx, state, from.tg1inIndx);
+			mapBlock(res, to.tg11Idx, state, from.tg11Idx);
+			mapBlock(res, to.tg12Idx, state, from.tg12Idx);
+			mapBlock(res, to.tg13Idx, state, from.tg13Idx);
+			mapBlock(res, to.tg2gIdx, state, from.tg2gIdx);
+			mapBlock(res, to.tg2mIdx, state, from.tg2mIdx);
+			mapBlock(res, to.tmechIdx, state, from.tmechIdx);
+			mapBlock(res, to.fIdx, state, from.fIdx);
+			mapBlock(res, to.qpltIdx, state, from.qpltIdx);
+			mapBlock(res, to.vgIdx, state, from.vgIdx);
+			return res;
+		}
+
 		CheYMatrix CheCompUtil::getCheYMatrix(const chedata::PsatDataSet &cheData, const list<Fault> &faultList) {
 			CheYMatrix yMatrix = CheYMatrix();
 
@@ -294,6 +379,32 @@ namespace che {
 			return yMatrix;
 		}
 
+		shared_ptr<const CheYMatrix> CheCompUtil::getSharedYMatrix(const chedata::PsatDataSet &cheData) {
+			long key = cheData.getNetworkId();
+			{
+				std::lock_guard<std::mutex> lock(yMatrixMutex);
+				map<long, weak_ptr<const CheYMatrix>>::iterator itr = yMatrixCache.find(key);
+				if (itr != yMatrixCache.end()) {
+					shared_ptr<const CheYMatrix> yMatrix = itr->second.lock();
+					if (yMatrix) {
+						return yMatrix;
+					}
+				}
+			}
+			// assembled outside the lock, a concurrent miss on the same key only costs a duplicate assembly
+			shared_ptr<const CheYMatrix> yMatrix(new CheYMatrix(getCheYMatrix(cheData)));
+			std::lock_guard<std::mutex> lock(yMatrixMutex);
+			for (map<long, weak_ptr<const CheYMatrix>>::iterator itr = yMatrixCache.begin(); itr != yMatrixCache.end();) {
+				if (itr->second.expired()) {
+					itr = yMatrixCache.erase(itr);
+				} else {
+					++itr;
+				}
+			}
+			yMatrixCache[key] = yMatrix;
+			return yMatrix;
+		}
+
 		static chedata::PsatDataSet getCheSubSet(const chedata::PsatDataSet &cheData, const uvec &busIdx) {
 			assert(cheData.isFormatted);
 			uvec busTag(cheData.nBus, fill::zeros);
@@ -311,85 +422,94 @@ namespace che {
 			uvec itg = find(synTag(cheData.get_tgs_synNumber_vec() - 1) == 1);
 			uvec iexc = find(synTag(cheData.get_excs_synNumber_vec() - 1) == 1);
 
+			uvec synMap(synTag.n_rows, fill::zeros);
+			synMap(isyn) = regspace<uvec>(1, isyn.n_rows);
+
 			chedata::PsatDataSet newCheData;
-			newCheData.nBus = busTag.n_rows;
+			newCheData.nBus = busIdx.n_rows;
 			if (newCheData.nBus > 0) {
-				newCheData.buses = new chedata::Bus[newCheData.nBus];
+				newCheData.alloc_buses(newCheData.nBus);
 				for (int i = 0; i < newCheData.nBus; i++) {
 					newCheData.buses[i] = chedata::Bus(cheData.buses[busIdx(i)]);
+					// The components of a formatted set refer to buses by position, so renumberBuses() of the
+					// subset has to map from the same numbering.
+					newCheData.buses[i].busNumber = busIdx(i) + 1;
 				}
 			}
 			newCheData.nSw = isw.n_rows;
 			if (newCheData.nSw > 0) {
-				newCheData.sws = new chedata::SW[newCheData.nSw];
+				newCheData.alloc_sws(newCheData.nSw);
 				for (int i = 0; i < newCheData.nSw; i++) {
 					newCheData.sws[i] = chedata::SW(cheData.sws[isw(i)]);
 				}
 			}
 			newCheData.nPv = ipv.n_rows;
 			if (newCheData.nPv > 0) {
-				newCheData.pvs = new chedata::PV[newCheData.nPv];
+				newCheData.alloc_pvs(newCheData.nPv);
 				for (int i = 0; i < newCheData.nPv; i++) {
 					newCheData.pvs[i] = chedata::PV(cheData.pvs[ipv(i)]);
 				}
 			}
 			newCheData.nPq = ipq.n_rows;
 			if (newCheData.nPq > 0) {
-				newCheData.pqs = new chedata::PQ[newCheData.nPq];
+				newCheData.alloc_pqs(newCheData.nPq);
 				for (int i = 0; i < newCheData.nPq; i++) {
 					newCheData.pqs[i] = chedata::PQ(cheData.pqs[ipq(i)]);
 				}
 			}
 			newCheData.nShunt = ishunt.n_rows;
 			if (newCheData.nShunt > 0) {
-				newCheData.shunts = new chedata::Shunt[newCheData.nShunt];
+				newCheData.alloc_shunts(newCheData.nShunt);
 				for (int i = 0; i < newCheData.nShunt; i++) {
 					newCheData.shunts[i] = chedata::Shunt(cheData.shunts[ishunt(i)]);
 				}
 			}
 			newCheData.nLine = iline.n_rows;
 			if (newCheData.nLine > 0) {
-				newCheData.lines = new chedata::Line[newCheData.nLine];
+				newCheData.alloc_lines(newCheData.nLine);
 				for (int i = 0; i < newCheData.nLine; i++) {
 					newCheData.lines[i] = chedata::Line(cheData.lines[iline(i)]);
 				}
 			}
 			newCheData.nPl = ipl.n_rows;
 			if (newCheData.nPl > 0) {
-				newCheData.pls = new chedata::Pl[newCheData.nPl];
+				newCheData.alloc_pls(newCheData.nPl);
 				for (int i = 0; i < newCheData.nPl; i++) {
 					newCheData.pls[i] = chedata::Pl(cheData.pls[ipl(i)]);
 				}
 			}
 			newCheData.nSyn = isyn.n_rows;
 			if (newCheData.nSyn > 0) {
-				newCheData.syns = new chedata::Syn[newCheData.nSyn];
+				newCheData.alloc_syns(newCheData.nSyn);
 				for (int i = 0; i < newCheData.nSyn; i++) {
 					newCheData.syns[i] = chedata::Syn(cheData.syns[isyn(i)]);
 				}
 			}
 			newCheData.nInd = iind.n_rows;
 			if (newCheData.nInd > 0) {
-				newCheData.inds = new chedata::Ind[newCheData.nInd];
+				newCheData.alloc_inds(newCheData.nInd);
 				for (int i = 0; i < newCheData.nInd; i++) {
 					newCheData.inds[i] = chedata::Ind(cheData.inds[iind(i)]);
 				}
 			}
 			newCheData.nTg = itg.n_rows;
 			if (newCheData.nTg > 0) {
-				newCheData.tgs = new chedata::Tg[newCheData.nTg];
+				newCheData.alloc_tgs(newCheData.nTg);
 				for (int i = 0; i < newCheData.nTg; i++) {
 					newCheData.tgs[i] = chedata::Tg(cheData.tgs[itg(i)]);
+					newCheData.tgs[i].synNumber = synMap(newCheData.tgs[i].synNumber - 1);
 				}
 			}
 			newCheData.nExc = iexc.n_rows;
 			if (newCheData.nExc > 0) {
-				newCheData.excs = new chedata::Exc[newCheData.nExc];
+				newCheData.alloc_excs(newCheData.nExc);
 				for (int i = 0; i < newCheData.nExc; i++) {
 					newCheData.excs[i] = chedata::Exc(cheData.excs[iexc(i)]);
+					newCheData.excs[i].synNumber = synMap(newCheData.excs[i].synNumber - 1);
 				}
 			}
 			newCheData.renumberBuses();
+			newCheData.invalidateColumns();
 			return newCheData;
 		}
 
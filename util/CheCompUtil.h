@@ -32,6 +32,7 @@
 #include "util/CheYMatrix.h"
 #include "util/CheEvents.h"
 #include <list>
+#include <memory>
 #include <vector>
 #include <assert.h>
 #include <sstream>
@@ -43,8 +44,14 @@ namespace che {
 	namespace util {
 		class CheCompUtil {
 		public:
-			static CheStateIdx getCheStateIdx(const chedata::PsatDataSet &cheData);
+			static CheStateIdx getCheStateIdx(const chedata::PsatDataSet &cheData, int blocks = CHESTATE_ALL);
+			/** @brief Immutable layout shared by all states of datasets with the same component counts. */
+			static shared_ptr<const CheStateIdx> getSharedStateIdx(const chedata::PsatDataSet &cheData, int blocks = CHESTATE_ALL);
+			/** @brief Copies every block present in both layouts from state (layout from) into a zero vector of layout to. */
+			static vec mapState(const vec &state, const CheStateIdx &from, const CheStateIdx &to);
 			static CheYMatrix getCheYMatrix(const chedata::PsatDataSet &cheData, const list<Fault> &faultList = list<Fault>());
+			/** @brief Fault-free Y matrix shared by every dataset with the same network id. */
+			static shared_ptr<const CheYMatrix> getSharedYMatrix(const chedata::PsatDataSet &cheData);
 			static list<chedata::PsatDataSet> splitIslands(const chedata::PsatDataSet &cheData, const uvec &islands);
 			static uvec searchIslands(const chedata::PsatDataSet &cheData);
 			static umat spgetseq(int n, int d);
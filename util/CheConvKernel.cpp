@@ -0,0 +1,207 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#include "util/CheConvKernel.h"
+
+namespace che {
+	namespace util {
+		template <typename T>
+		static void prepareOut(Col<T> &out, uword n, bool accumulate) {
+			if (!accumulate || out.n_elem != n) {
+				out.zeros(n);
+			}
+		}
+
+		static inline const double *cxColPtr(const cx_mat &A, uword col) {
+			return reinterpret_cast<const double *>(A.colptr(col));
+		}
+
+		void CheConvKernel::cauchyRR(const mat &A, const mat &B, const umat &seq, vec &out, bool accumulate) {
+			const uword n = A.n_rows;
+			prepareOut(out, n, accumulate);
+			double *po = out.memptr();
+			for (uword r = 0; r < seq.n_rows; r++) {
+				const double *pa = A.colptr(seq(r, 0));
+				const double *pb = B.colptr(seq(r, 1));
+				for (uword i = 0; i < n; i++) {
+					po[i] += pa[i] * pb[i];
+				}
+			}
+		}
+
+		void CheConvKernel::cauchyRRR(const mat &A, const mat &B, const mat &C, const umat &seq, vec &out, bool accumulate) {
+			const uword n = A.n_rows;
+			prepareOut(out, n, accumulate);
+			double *po = out.memptr();
+			for (uword r = 0; r < seq.n_rows; r++) {
+				const double *pa = A.colptr(seq(r, 0));
+				const double *pb = B.colptr(seq(r, 1));
+				const double *pc = C.colptr(seq(r, 2));
+				for (uword i = 0; i < n; i++) {
+					po[i] += pa[i] * pb[i] * pc[i];
+				}
+			}
+		}
+
+		void CheConvKernel::cauchyRRRR(const mat &A, const mat &B, const mat &C, const mat &D, const umat &seq, vec &out, bool accumulate) {
+			const uword n = A.n_rows;
+			prepareOut(out, n, accumulate);
+			double *po = out.memptr();
+			for (uword r = 0; r < seq.n_rows; r++) {
+				const double *pa = A.colptr(seq(r, 0));
+				const double *pb = B.colptr(seq(r, 1));
+				const double *pc = C.colptr(seq(r, 2));
+				const double *pd = D.colptr(seq(r, 3));
+				for (uword i = 0; i < n; i++) {
+					po[i] += pa[i] * pb[i] * pc[i] * pd[i];
+				}
+			}
+		}
+
+		void CheConvKernel::cauchyCR(const cx_mat &A, const mat &B, const umat &seq, cx_vec &out, bool accumulate) {
+			const uword n = A.n_rows;
+			prepareOut(out, n, accumulate);
+			double *po = reinterpret_cast<double *>(out.memptr());
+			for (uword r = 0; r < seq.n_rows; r++) {
+				const double *pa = cxColPtr(A, seq(r, 0));
+				const double *pb = B.colptr(seq(r, 1));
+				for (uword i = 0; i < n; i++) {
+					po[2 * i] += pa[2 * i] * pb[i];
+					po[2 * i + 1] += pa[2 * i + 1] * pb[i];
+				}
+			}
+		}
+
+		void CheConvKernel::cauchyCRRows(const cx_mat &A, const uvec &rows, const mat &B, const umat &seq, cx_vec &out, bool accumulate) {
+			const uword n = rows.n_elem;
+			prepareOut(out, n, accumulate);
+			double *po = reinterpret_cast<double *>(out.memptr());
+			const uword *pr = rows.memptr();
+			for (uword r = 0; r < seq.n_rows; r++) {
+				const double *pa = cxColPtr(A, seq(r, 0));
+				const double *pb = B.colptr(seq(r, 1));
+				for (uword i = 0; i < n; i++) {
+					po[2 * i] += pa[2 * pr[i]] * pb[i];
+					po[2 * i + 1] += pa[2 * pr[i] + 1] * pb[i];
+				}
+			}
+		}
+
+		void CheConvKernel::cauchyCC(const cx_mat &A, const cx_mat &B, const umat &seq, cx_vec &out, bool accumulate) {
+			const uword n = A.n_rows;
+			prepareOut(out, n, accumulate);
+			double *po = reinterpret_cast<double *>(out.memptr());
+			for (uword r = 0; r < seq.n_rows; r++) {
+				const double *pa = cxColPtr(A, seq(r, 0));
+				const double *pb = cxColPtr(B, seq(r, 1));
+				for (uword i = 0; i < n; i++) {
+					po[2 * i] += pa[2 * i] * pb[2 * i] - pa[2 * i + 1] * pb[2 * i + 1];
+					po[2 * i + 1] += pa[2 * i] * pb[2 * i + 1] + pa[2 * i + 1] * pb[2 * i];
+				}
+			}
+		}
+
+		void CheConvKernel::cauchyCConj(const cx_mat &A, const cx_mat &B, const umat &seq, cx_vec &out, bool accumulate) {
+			const uword n = A.n_rows;
+			prepareOut(out, n, accumulate);
+			double *po = reinterpret_cast<double *>(out.memptr());
+			for (uword r = 0; r < seq.n_rows; r++) {
+				const double *pa = cxColPtr(A, seq(r, 0));
+				const double *pb = cxColPtr(B, seq(r, 1));
+				for (uword i = 0; i < n; i++) {
+					po[2 * i] += pa[2 * i] * pb[2 * i] + pa[2 * i + 1] * pb[2 * i + 1];
+					po[2 * i + 1] += pa[2 * i + 1] * pb[2 * i] - pa[2 * i] * pb[2 * i + 1];
+				}
+			}
+		}
+
+		void CheConvKernel::cauchyCConjRows(const cx_mat &A, const uvec &rowsA, const cx_mat &B, const uvec &rowsB, const umat &seq, cx_vec &out, bool accumulate) {
+			const uword n = rowsA.n_elem;
+			prepareOut(out, n, accumulate);
+			double *po = reinterpret_cast<double *>(out.memptr());
+			const uword *pra = rowsA.memptr();
+			const uword *prb = rowsB.memptr();
+			for (uword r = 0; r < seq.n_rows; r++) {
+				const double *pa = cxColPtr(A, seq(r, 0));
+				const double *pb = cxColPtr(B, seq(r, 1));
+				for (uword i = 0; i < n; i++) {
+					const double ar = pa[2 * pra[i]];
+					const double ai = pa[2 * pra[i] + 1];
+					const double br = pb[2 * prb[i]];
+					const double bi = pb[2 * prb[i] + 1];
+					po[2 * i] += ar * br + ai * bi;
+					po[2 * i + 1] += ai * br - ar * bi;
+				}
+			}
+		}
+
+		void CheConvKernel::cauchyCConjRows(const cx_mat &A, const uvec &rows, const cx_mat &B, const umat &seq, cx_vec &out, bool accumulate) {
+			const uword n = rows.n_elem;
+			prepareOut(out, n, accumulate);
+			double *po = reinterpret_cast<double *>(out.memptr());
+			const uword *pr = rows.memptr();
+			for (uword r = 0; r < seq.n_rows; r++) {
+				const double *pa = cxColPtr(A, seq(r, 0));
+				const double *pb = cxColPtr(B, seq(r, 1));
+				for (uword i = 0; i < n; i++) {
+					const double ar = pa[2 * pr[i]];
+					const double ai = pa[2 * pr[i] + 1];
+					po[2 * i] += ar * pb[2 * i] + ai * pb[2 * i + 1];
+					po[2 * i + 1] += ai * pb[2 * i] - ar * pb[2 * i + 1];
+				}
+			}
+		}
+
+		void CheConvKernel::cauchyRConj(const mat &A, const cx_mat &B, const umat &seq, cx_vec &out, bool accumulate) {
+			const uword n = A.n_rows;
+			prepareOut(out, n, accumulate);
+			double *po = reinterpret_cast<double *>(out.memptr());
+			for (uword r = 0; r < seq.n_rows; r++) {
+				const double *pa = A.colptr(seq(r, 0));
+				const double *pb = cxColPtr(B, seq(r, 1));
+				for (uword i = 0; i < n; i++) {
+					po[2 * i] += pa[i] * pb[2 * i];
+					po[2 * i + 1] -= pa[i] * pb[2 * i + 1];
+				}
+			}
+		}
+
+		void CheConvKernel::cauchyReCConjSplitRows(const cx_mat &A, const uvec &rows, const mat &Br, const mat &Bi, const umat &seq, vec &out, bool accumulate) {
+			const uword n = rows.n_elem;
+			prepareOut(out, n, accumulate);
+			double *po = out.memptr();
+			const uword *pr = rows.memptr();
+			for (uword r = 0; r < seq.n_rows; r++) {
+				const double *pa = cxColPtr(A, seq(r, 0));
+				const double *pbr = Br.colptr(seq(r, 1));
+				const double *pbi = Bi.colptr(seq(r, 1));
+				for (uword i = 0; i < n; i++) {
+					po[i] += pa[2 * pr[i]] * pbr[i] + pa[2 * pr[i] + 1] * pbi[i];
+				}
+			}
+		}
+	} // namespace util
+} // namespace che
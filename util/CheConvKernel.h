@@ -0,0 +1,88 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#ifndef _Che_ConvKernel_H_
+#define _Che_ConvKernel_H_
+
+#include "util/SafeArmadillo.h"
+
+using namespace arma;
+
+namespace che {
+	namespace util {
+		/**
+		 * @brief Fused Cauchy-product kernels of the series recursion.
+		 *
+		 * Each kernel evaluates out(i) = sum_r f(A(i, seq(r, 0)), B(i, seq(r, 1)), ...) by streaming the
+		 * coefficient columns directly, so no gathered temporaries are created. The output vector is
+		 * resized only when its length changes, which makes the kernels allocation-free when the
+		 * caller keeps the outputs alive across levels. With accumulate = true the result is added to
+		 * the current content of out instead of overwriting it.
+		 *
+		 * Complex operands are read as interleaved (re, im) pairs and the real and imaginary parts are
+		 * accumulated separately, so the inner loops are plain fused multiply-adds over contiguous
+		 * memory that the compiler vectorizes. The *Rows variants read the complex operand through a
+		 * row index vector (e.g. the buses of the devices), the output then has rows.n_rows entries.
+		 */
+		class CheConvKernel {
+		public:
+			// sum A_a * B_b
+			static void cauchyRR(const mat &A, const mat &B, const umat &seq, vec &out, bool accumulate = false);
+
+			// sum A_a * B_b * C_c
+			static void cauchyRRR(const mat &A, const mat &B, const mat &C, const umat &seq, vec &out, bool accumulate = false);
+
+			// sum A_a * B_b * C_c * D_d
+			static void cauchyRRRR(const mat &A, const mat &B, const mat &C, const mat &D, const umat &seq, vec &out, bool accumulate = false);
+
+			// sum A_a * B_b, A complex, B real
+			static void cauchyCR(const cx_mat &A, const mat &B, const umat &seq, cx_vec &out, bool accumulate = false);
+
+			// sum A(rows)_a * B_b, A complex, B real
+			static void cauchyCRRows(const cx_mat &A, const uvec &rows, const mat &B, const umat &seq, cx_vec &out, bool accumulate = false);
+
+			// sum A_a * B_b, both complex
+			static void cauchyCC(const cx_mat &A, const cx_mat &B, const umat &seq, cx_vec &out, bool accumulate = false);
+
+			// sum A_a * conj(B_b), both complex
+			static void cauchyCConj(const cx_mat &A, const cx_mat &B, const umat &seq, cx_vec &out, bool accumulate = false);
+
+			// sum A(rowsA)_a * conj(B(rowsB)_b), both complex
+			static void cauchyCConjRows(const cx_mat &A, const uvec &rowsA, const cx_mat &B, const uvec &rowsB, const umat &seq, cx_vec &out, bool accumulate = false);
+
+			// sum A(rows)_a * conj(B_b), both complex, B indexed directly
+			static void cauchyCConjRows(const cx_mat &A, const uvec &rows, const cx_mat &B, const umat &seq, cx_vec &out, bool accumulate = false);
+
+			// sum A_a * conj(B_b), A real, B complex
+			static void cauchyRConj(const mat &A, const cx_mat &B, const umat &seq, cx_vec &out, bool accumulate = false);
+
+			// sum real(A(rows)_a * conj(Br_b + j * Bi_b)), the split real/imag form of a complex B
+			static void cauchyReCConjSplitRows(const cx_mat &A, const uvec &rows, const mat &Br, const mat &Bi, const umat &seq, vec &out, bool accumulate = false);
+		};
+	} // namespace util
+} // namespace che
+
+#endif
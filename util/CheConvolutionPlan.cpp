@@ -0,0 +1,74 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#include "util/CheConvolutionPlan.h"
+#include "util/CheCompUtil.h"
+#include <map>
+#include <mutex>
+
+namespace che {
+	namespace util {
+		static std::mutex planMutex;
+		static map<pair<int, int>, shared_ptr<const CheConvolutionPlan>> planCache;
+
+		umat CheConvolutionPlan::getReducedSeq(int n, int d) {
+			umat seq = CheCompUtil::spgetseq(n, d);
+			uvec idxSeq = any(seq == n, 1);
+			return seq.rows(find(idxSeq == 0));
+		}
+
+		CheConvolutionPlan::CheConvolutionPlan(int nLvl, int nTaylor) {
+			this->nLvl = nLvl;
+			this->nTaylor = nTaylor;
+			seq2.reserve(nLvl);
+			seq2m.reserve(nLvl);
+			seq2R.reserve(nLvl);
+			seq3R.reserve(nLvl);
+			seq4R.reserve(nLvl);
+			for (int lvl = 0; lvl < nLvl; lvl++) {
+				umat s2 = CheCompUtil::spgetseq(lvl + 1, 2);
+				uvec idxSeq2 = any(s2 == lvl + 1, 1);
+				seq2R.push_back(s2.rows(find(idxSeq2 == 0)));
+				seq2.push_back(s2);
+				seq2m.push_back(CheCompUtil::spgetseq(lvl, 2));
+				seq3R.push_back(nTaylor >= 3 ? getReducedSeq(lvl + 1, 3) : umat(0, 3));
+				seq4R.push_back(nTaylor >= 4 ? getReducedSeq(lvl + 1, 4) : umat(0, 4));
+			}
+		}
+
+		shared_ptr<const CheConvolutionPlan> CheConvolutionPlan::getPlan(int nLvl, int nTaylor) {
+			std::lock_guard<std::mutex> lock(planMutex);
+			pair<int, int> key(nLvl, nTaylor);
+			map<pair<int, int>, shared_ptr<const CheConvolutionPlan>>::iterator itr = planCache.find(key);
+			if (itr != planCache.end()) {
+				return itr->second;
+			}
+			shared_ptr<const CheConvolutionPlan> plan(new CheConvolutionPlan(nLvl, nTaylor));
+			planCache.insert(make_pair(key, plan));
+			return plan;
+		}
+	} // namespace util
+} // namespace che
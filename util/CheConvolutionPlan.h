@@ -0,0 +1,74 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#ifndef _Che_ConvolutionPlan_H_
+#define _Che_ConvolutionPlan_H_
+
+#include "util/SafeArmadillo.h"
+#include <memory>
+#include <vector>
+
+using namespace arma;
+using namespace std;
+
+namespace che {
+	namespace util {
+		/**
+		 * @brief Index tables of the Cauchy products used by the series recursion.
+		 *
+		 * For every level lvl in [0, nLvl) the plan holds the rows of CheCompUtil::spgetseq that
+		 * the level loop needs, already filtered so that the unknown coefficient (lvl + 1) is
+		 * excluded. The tables only depend on (nLvl, nTaylor), so one plan is built per pair and
+		 * shared by all stages and calculators of the process through getPlan().
+		 */
+		class CheConvolutionPlan {
+		public:
+			int nLvl;
+			int nTaylor;
+			// seq2[lvl]  = spgetseq(lvl + 1, 2)
+			vector<umat> seq2;
+			// seq2m[lvl] = spgetseq(lvl, 2)
+			vector<umat> seq2m;
+			// seqXR[lvl] = rows of spgetseq(lvl + 1, X) that do not contain lvl + 1
+			vector<umat> seq2R;
+			vector<umat> seq3R;
+			vector<umat> seq4R;
+
+			static shared_ptr<const CheConvolutionPlan> getPlan(int nLvl, int nTaylor);
+
+			CheConvolutionPlan(const CheConvolutionPlan &) = delete;
+
+			CheConvolutionPlan &operator=(const CheConvolutionPlan &) = delete;
+
+		private:
+			CheConvolutionPlan(int nLvl, int nTaylor);
+
+			static umat getReducedSeq(int n, int d);
+		};
+	} // namespace util
+} // namespace che
+
+#endif
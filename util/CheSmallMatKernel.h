@@ -0,0 +1,139 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#ifndef _Che_SmallMatKernel_H_
+#define _Che_SmallMatKernel_H_
+
+#include "util/SafeArmadillo.h"
+#include <cmath>
+#include <algorithm>
+
+using namespace arma;
+
+namespace che {
+	namespace util {
+		/**
+		 * @brief Batched fixed-size dense kernels for per-device blocks (e.g. the induction motor model).
+		 *
+		 * A batch of n blocks of size R x C is packed as a structure of arrays: a mat with n rows and R * C
+		 * columns, where column r + c * R holds element (r, c) of every block. A vector block (C = 1) is
+		 * therefore simply one column per entry. The block sizes are template arguments, so the loops over
+		 * the block entries are unrolled and the products stream over contiguous columns across all
+		 * devices, which the compiler vectorizes.
+		 */
+		class CheSmallMatKernel {
+		public:
+			// out = A * X per block, A R x K, X K x C. With accumulate = true the product is added to out.
+			template <int R, int K, int C>
+			static void mul(const mat &A, const mat &X, mat &out, bool accumulate = false) {
+				const uword n = A.n_rows;
+				if (out.n_rows != n || out.n_cols != R * C) {
+					out.set_size(n, R * C);
+					accumulate = false;
+				}
+				for (int c = 0; c < C; c++) {
+					for (int r = 0; r < R; r++) {
+						double *o = out.colptr(r + c * R);
+						if (!accumulate) {
+							for (uword i = 0; i < n; i++)
+								o[i] = 0.;
+						}
+						for (int k = 0; k < K; k++) {
+							const double *a = A.colptr(r + k * R);
+							const double *x = X.colptr(k + c * K);
+							for (uword i = 0; i < n; i++)
+								o[i] += a[i] * x[i];
+						}
+					}
+				}
+			}
+
+			// Ainv = inv(A) per N x N block, Gauss-Jordan elimination with partial pivoting. Returns the number of
+			// singular blocks; their rows of Ainv are filled with NaN.
+			template <int N>
+			static int inv(const mat &A, mat &Ainv) {
+				const uword n = A.n_rows;
+				Ainv.set_size(n, N * N);
+				int nSingular = 0;
+				for (uword i = 0; i < n; i++) {
+					double a[N][N];
+					double b[N][N];
+					for (int c = 0; c < N; c++) {
+						for (int r = 0; r < N; r++) {
+							a[r][c] = A(i, r + c * N);
+							b[r][c] = (r == c) ? 1. : 0.;
+						}
+					}
+					bool singular = false;
+					for (int c = 0; c < N && !singular; c++) {
+						int p = c;
+						for (int r = c + 1; r < N; r++) {
+							if (std::abs(a[r][c]) > std::abs(a[p][c]))
+								p = r;
+						}
+						if (a[p][c] == 0. || !std::isfinite(a[p][c])) {
+							singular = true;
+							break;
+						}
+						if (p != c) {
+							for (int k = 0; k < N; k++) {
+								std::swap(a[p][k], a[c][k]);
+								std::swap(b[p][k], b[c][k]);
+							}
+						}
+						double piv = 1. / a[c][c];
+						for (int k = 0; k < N; k++) {
+							a[c][k] *= piv;
+							b[c][k] *= piv;
+						}
+						for (int r = 0; r < N; r++) {
+							if (r == c)
+								continue;
+							double f = a[r][c];
+							for (int k = 0; k < N; k++) {
+								a[r][k] -= f * a[c][k];
+								b[r][k] -= f * b[c][k];
+							}
+						}
+					}
+					if (singular) {
+						nSingular++;
+						Ainv.row(i).fill(datum::nan);
+						continue;
+					}
+					for (int c = 0; c < N; c++) {
+						for (int r = 0; r < N; r++) {
+							Ainv(i, r + c * N) = b[r][c];
+						}
+					}
+				}
+				return nSingular;
+			}
+		};
+	} // namespace util
+} // namespace che
+
+#endif
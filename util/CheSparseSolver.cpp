@@ -0,0 +1,765 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#include "util/CheSparseSolver.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+
+#if defined(ARMA_USE_SUPERLU)
+
+extern "C" {
+extern void arma_wrapper(dgstrs)(superlu::trans_t, superlu::SuperMatrix *, superlu::SuperMatrix *, int *, int *, superlu::SuperMatrix *, superlu::SuperLUStat_t *, int *);
+extern void arma_wrapper(get_perm_c)(int, superlu::SuperMatrix *, int *);
+}
+
+#endif
+
+namespace che {
+	namespace util {
+		// COLAMD in SuperLU's colperm_t
+		static const int SUPERLU_COLAMD = 3;
+		// MY_PERMC in SuperLU 6.0, not listed in armadillo's colperm_t
+		static const int SUPERLU_MY_PERMC = 8;
+		// A reused factorization is rejected when the pivot growth or the condition estimate
+		// degrades by more than this factor relative to the last fresh factorization.
+		static const double REUSE_DEGRADE_TOL = 1e-3;
+		// Threshold partial pivoting: the diagonal is kept if it is at least this fraction of the column max.
+		static const double PIVOT_TOL = 0.1;
+		// Below this size the parallel LU runs sequentially.
+		static const int PARALLEL_MIN_SIZE = 2000;
+
+		bool CheSparseSolver::hasSamePattern(const sp_mat &A) const {
+			A.sync();
+			return patternColPtr.n_elem == A.n_cols + 1 && patternRowIdx.n_elem == A.n_nonzero &&
+				   std::equal(A.col_ptrs, A.col_ptrs + A.n_cols + 1, patternColPtr.memptr()) &&
+				   std::equal(A.row_indices, A.row_indices + A.n_nonzero, patternRowIdx.memptr());
+		}
+
+		void CheSparseSolver::savePattern(const sp_mat &A) {
+			A.sync();
+			patternColPtr = uvec(A.col_ptrs, A.n_cols + 1);
+			patternRowIdx = uvec(A.row_indices, A.n_nonzero);
+		}
+
+		static vector<int> getColamdOrdering(const sp_mat &A) {
+			int n = A.n_cols;
+			vector<int> perm(n + 1, 0);
+			arma::superlu::SuperMatrix superA;
+			arrayops::inplace_set(reinterpret_cast<char *>(&superA), char(0), sizeof(arma::superlu::SuperMatrix));
+			sp_auxlib::copy_to_supermatrix(superA, A);
+			arma_wrapper(get_perm_c)(SUPERLU_COLAMD, &superA, perm.data());
+			sp_auxlib::destroy_supermatrix(superA);
+			return perm;
+		}
+
+		// ========================== SuperLU ==========================
+
+		CheSuperLuSolver::CheSuperLuSolver() : n(0), analyzed(false), factored(false), luAllocated(false),
+											   rpg(0.0), rcond(0.0), refRpg(0.0), refRcond(0.0) {
+			superlu_opts superlu_opts_default;
+			sp_auxlib::set_superlu_opts(options, superlu_opts_default);
+			options.IterRefine = arma::superlu::NOREFINE;
+			options.RefineInitialized = arma::superlu::NO;
+			options.Equil = arma::superlu::NO; // runGssvx wraps the caller's matrix, which must not be scaled
+			options.PivotGrowth = arma::superlu::YES;
+			options.ConditionNumber = arma::superlu::YES;
+			arrayops::inplace_set(reinterpret_cast<char *>(&L), char(0), sizeof(arma::superlu::SuperMatrix));
+			arrayops::inplace_set(reinterpret_cast<char *>(&U), char(0), sizeof(arma::superlu::SuperMatrix));
+			arrayops::inplace_set(reinterpret_cast<char *>(&glu), char(0), sizeof(arma::superlu::GlobalLU_t));
+			arrayops::inplace_set(equed, char(0), 8);
+			arma::superlu::init_stat(&stat);
+		}
+
+		CheSuperLuSolver::~CheSuperLuSolver() {
+			releaseFactors();
+			arma::superlu::free_stat(&stat);
+		}
+
+		void CheSuperLuSolver::releaseFactors() {
+			if (luAllocated) {
+				sp_auxlib::destroy_supermatrix(L);
+				sp_auxlib::destroy_supermatrix(U);
+				arrayops::inplace_set(reinterpret_cast<char *>(&L), char(0), sizeof(arma::superlu::SuperMatrix));
+				arrayops::inplace_set(reinterpret_cast<char *>(&U), char(0), sizeof(arma::superlu::SuperMatrix));
+				luAllocated = false;
+			}
+			factored = false;
+		}
+
+		bool CheSuperLuSolver::analyze(const sp_mat &A) {
+			releaseFactors();
+			n = A.n_cols;
+			permC = getColamdOrdering(A);
+			permR.assign(n + 1, 0);
+			etree.assign(n + 1, 0);
+			R.assign(n + 1, 0.0);
+			C.assign(n + 1, 0.0);
+			savePattern(A);
+			colPtr.assign(A.col_ptrs, A.col_ptrs + A.n_cols + 1);
+			rowIdx.assign(A.row_indices, A.row_indices + A.n_nonzero);
+			analyzed = true;
+			stats.nAnalyze++;
+			return true;
+		}
+
+		bool CheSuperLuSolver::runGssvx(const sp_mat &A, arma::superlu::fact_t fact) {
+			arma::superlu::SuperMatrix superA;
+			arma::superlu::SuperMatrix superB;
+			arma::superlu::SuperMatrix superX;
+			arrayops::inplace_set(reinterpret_cast<char *>(&superA), char(0), sizeof(arma::superlu::SuperMatrix));
+			arrayops::inplace_set(reinterpret_cast<char *>(&superB), char(0), sizeof(arma::superlu::SuperMatrix));
+			arrayops::inplace_set(reinterpret_cast<char *>(&superX), char(0), sizeof(arma::superlu::SuperMatrix));
+			// A has the analyzed pattern, so its values are wrapped as they are with the indices converted by
+			// analyze(). dgssvx does not write to A as long as equilibration is off.
+			A.sync();
+			arma::superlu::NCformat storeA;
+			storeA.nnz = A.n_nonzero;
+			storeA.nzval = const_cast<double *>(A.values);
+			storeA.rowind = rowIdx.data();
+			storeA.colptr = colPtr.data();
+			superA.Stype = arma::superlu::SLU_NC;
+			superA.Dtype = arma::superlu::SLU_D;
+			superA.Mtype = arma::superlu::SLU_GE;
+			superA.nrow = A.n_rows;
+			superA.ncol = A.n_cols;
+			superA.Store = &storeA;
+			// dgssvx always solves as well, a zero right-hand side keeps that cheap
+			mat b(n, 1, fill::zeros);
+			mat x(n, 1, fill::zeros);
+			sp_auxlib::wrap_to_supermatrix(superB, b);
+			sp_auxlib::wrap_to_supermatrix(superX, x);
+
+			arma::superlu::mem_usage_t mu;
+			arrayops::inplace_set(reinterpret_cast<char *>(&mu), char(0), sizeof(arma::superlu::mem_usage_t));
+			double ferr[2] = {0.0, 0.0};
+			double berr[2] = {0.0, 0.0};
+			char work[8];
+			int lwork = 0; // 0 means superlu will allocate memory
+			int info = 0;
+
+			options.Fact = fact;
+			options.ColPerm = static_cast<arma::superlu::colperm_t>(SUPERLU_MY_PERMC);
+			arma_wrapper(dgssvx)(&options, &superA, permC.data(), permR.data(), etree.data(), equed, R.data(), C.data(),
+								 &L, &U, &work[0], lwork, &superB, &superX, &rpg, &rcond, ferr, berr, &glu, &mu, &stat, &info);
+
+			sp_auxlib::destroy_supermatrix(superX);
+			sp_auxlib::destroy_supermatrix(superB);
+
+			luAllocated = info >= 0 && info <= n;
+			factored = info == 0;
+			return factored;
+		}
+
+		bool CheSuperLuSolver::factor(const sp_mat &A) {
+			if (!analyzed || !hasSamePattern(A)) {
+				analyze(A);
+			}
+			releaseFactors();
+			bool ok = runGssvx(A, arma::superlu::DOFACT);
+			if (ok) {
+				refRpg = rpg;
+				refRcond = rcond;
+			}
+			stats.nFactor++;
+			return ok;
+		}
+
+		bool CheSuperLuSolver::refactor(const sp_mat &A) {
+			if (!factored || !hasSamePattern(A)) {
+				return factor(A);
+			}
+			// Same pattern: keep ordering, row permutation and the L/U structures.
+			if (runGssvx(A, arma::superlu::SamePattern_SameRowPerm) &&
+				rpg >= REUSE_DEGRADE_TOL * refRpg && rcond >= REUSE_DEGRADE_TOL * refRcond) {
+				stats.nRefactor++;
+				return true;
+			}
+			// The old pivot sequence is no longer acceptable, pivot afresh with the saved ordering.
+			releaseFactors();
+			if (runGssvx(A, arma::superlu::SamePattern)) {
+				refRpg = rpg;
+				refRcond = rcond;
+				stats.nRepivot++;
+				return true;
+			}
+			releaseFactors();
+			analyzed = false;
+			return factor(A);
+		}
+
+		bool CheSuperLuSolver::solve(mat &X, const mat &B) {
+			if (!factored) {
+				return false;
+			}
+			X = B;
+			if (X.n_cols == 0) {
+				return true;
+			}
+			arma::superlu::SuperMatrix superX;
+			arrayops::inplace_set(reinterpret_cast<char *>(&superX), char(0), sizeof(arma::superlu::SuperMatrix));
+			sp_auxlib::wrap_to_supermatrix(superX, X);
+			int info = 0;
+			arma_wrapper(dgstrs)(arma::superlu::NOTRANS, &L, &U, permC.data(), permR.data(), &superX, &stat, &info);
+			sp_auxlib::destroy_supermatrix(superX);
+			stats.nSolve++;
+			return info == 0;
+		}
+
+		bool CheSuperLuSolver::isFactored() const {
+			return factored;
+		}
+
+		const char *CheSuperLuSolver::getName() const {
+			return "superlu";
+		}
+
+		// ========================== Parallel left-looking LU ==========================
+
+		CheParallelLuSolver::Workspace::Workspace(int n)
+			: x(n, 0.0), rowMark(n, 0), stepMark(n, 0), topo(n, 0), stack(n, 0), pstack(n, 0), stamp(0) {
+			rowList.reserve(n);
+		}
+
+		CheParallelLuSolver::CheParallelLuSolver(int nThreads) : n(0), analyzed(false), factored(false), pool(NULL) {
+			this->nThreads = nThreads > 0 ? nThreads : CheThreadPool::getDefaultThreadCount();
+			if (this->nThreads > 1) {
+				pool = new CheThreadPool(this->nThreads);
+			}
+		}
+
+		CheParallelLuSolver::~CheParallelLuSolver() {
+			if (pool != NULL) {
+				delete pool;
+				pool = NULL;
+			}
+		}
+
+		bool CheParallelLuSolver::analyze(const sp_mat &A) {
+			A.sync();
+			n = A.n_cols;
+			factored = false;
+
+			// perm_c[i] = j means that column i of A is at position j of A * Pc
+			vector<int> permC = getColamdOrdering(A);
+			q.assign(n, 0);
+			for (int i = 0; i < n; i++) {
+				q[permC[i]] = i;
+			}
+
+			// Column elimination tree (etree of A(:, q)' * A(:, q)), parents always follow their children.
+			parent.assign(n, -1);
+			vector<int> ancestor(n, -1);
+			vector<int> prev(A.n_rows, -1);
+			for (int k = 0; k < n; k++) {
+				int col = q[k];
+				for (uword p = A.col_ptrs[col]; p < A.col_ptrs[col + 1]; p++) {
+					int row = A.row_indices[p];
+					int inext;
+					for (int i = prev[row]; i != -1 && i < k; i = inext) {
+						inext = ancestor[i];
+						ancestor[i] = k;
+						if (inext == -1) {
+							parent[i] = k;
+						}
+					}
+					prev[row] = k;
+				}
+			}
+			nChildren.assign(n, 0);
+			for (int k = 0; k < n; k++) {
+				if (parent[k] >= 0) {
+					nChildren[parent[k]]++;
+				}
+			}
+			leaves.clear();
+			for (int k = n - 1; k >= 0; k--) {
+				if (nChildren[k] == 0) {
+					leaves.push_back(k);
+				}
+			}
+
+			savePattern(A);
+			analyzed = true;
+			stats.nAnalyze++;
+			return true;
+		}
+
+		bool CheParallelLuSolver::factorColumn(const sp_mat &A, int j, Workspace &ws) {
+			int col = q[j];
+			int stamp = ++ws.stamp;
+			double *x = ws.x.data();
+			ws.rowList.clear();
+
+			// scatter A(:, col) and collect the pivot steps reachable through L, in topological order
+			int top = n;
+			for (uword p = A.col_ptrs[col]; p < A.col_ptrs[col + 1]; p++) {
+				int row = A.row_indices[p];
+				x[row] = A.values[p];
+				ws.rowMark[row] = stamp;
+				ws.rowList.push_back(row);
+			}
+			for (uword p = A.col_ptrs[col]; p < A.col_ptrs[col + 1]; p++) {
+				int k0 = pinv[A.row_indices[p]];
+				if (k0 < 0 || ws.stepMark[k0] == stamp) {
+					continue;
+				}
+				int head = 0;
+				ws.stack[0] = k0;
+				while (head >= 0) {
+					int k = ws.stack[head];
+					if (ws.stepMark[k] != stamp) {
+						ws.stepMark[k] = stamp;
+						ws.pstack[head] = 0;
+					}
+					bool done = true;
+					const vector<int> &lk = Li[k];
+					for (int pp = ws.pstack[head]; pp < (int)lk.size(); pp++) {
+						int kk = pinv[lk[pp]];
+						if (kk < 0 || ws.stepMark[kk] == stamp) {
+							continue;
+						}
+						ws.pstack[head] = pp + 1;
+						ws.stack[++head] = kk;
+						done = false;
+						break;
+					}
+					if (done) {
+						head--;
+						ws.topo[--top] = k;
+					}
+				}
+			}
+
+			// numeric update x -= L(:, k) * U(k, j)
+			vector<int> &ui = Ui[j];
+			vector<double> &ux = Ux[j];
+			ui.clear();
+			ux.clear();
+			for (int t = top; t < n; t++) {
+				int k = ws.topo[t];
+				double ukj = x[prow[k]];
+				ui.push_back(k);
+				ux.push_back(ukj);
+				const vector<int> &lk = Li[k];
+				const vector<double> &lv = Lx[k];
+				for (size_t pp = 0; pp < lk.size(); pp++) {
+					int row = lk[pp];
+					if (ws.rowMark[row] != stamp) {
+						ws.rowMark[row] = stamp;
+						ws.rowList.push_back(row);
+						x[row] = 0.0;
+					}
+					x[row] -= lv[pp] * ukj;
+				}
+			}
+
+			// threshold partial pivoting, preferring the diagonal
+			int ipiv = -1;
+			double maxAbs = 0.0;
+			for (size_t p = 0; p < ws.rowList.size(); p++) {
+				int row = ws.rowList[p];
+				if (pinv[row] < 0 && std::abs(x[row]) > maxAbs) {
+					maxAbs = std::abs(x[row]);
+					ipiv = row;
+				}
+			}
+			bool ok = ipiv >= 0 && maxAbs > 0.0;
+			if (ok) {
+				if (ws.rowMark[col] == stamp && pinv[col] < 0 && std::abs(x[col]) >= PIVOT_TOL * maxAbs) {
+					ipiv = col;
+				}
+				double piv = x[ipiv];
+				pinv[ipiv] = j;
+				prow[j] = ipiv;
+				Udiag[j] = piv;
+				vector<int> &li = Li[j];
+				vector<double> &lx = Lx[j];
+				li.clear();
+				lx.clear();
+				for (size_t p = 0; p < ws.rowList.size(); p++) {
+					int row = ws.rowList[p];
+					if (pinv[row] < 0) {
+						li.push_back(row);
+						lx.push_back(x[row] / piv);
+					}
+				}
+			}
+			for (size_t p = 0; p < ws.rowList.size(); p++) {
+				x[ws.rowList[p]] = 0.0;
+			}
+			return ok;
+		}
+
+		bool CheParallelLuSolver::refactorColumn(const sp_mat &A, int j, Workspace &ws) {
+			int col = q[j];
+			double *x = ws.x.data();
+			for (uword p = A.col_ptrs[col]; p < A.col_ptrs[col + 1]; p++) {
+				x[A.row_indices[p]] = A.values[p];
+			}
+			const vector<int> &ui = Ui[j];
+			vector<double> &ux = Ux[j];
+			for (size_t t = 0; t < ui.size(); t++) {
+				int k = ui[t];
+				double ukj = x[prow[k]];
+				ux[t] = ukj;
+				const vector<int> &lk = Li[k];
+				const vector<double> &lv = Lx[k];
+				for (size_t pp = 0; pp < lk.size(); pp++) {
+					x[lk[pp]] -= lv[pp] * ukj;
+				}
+			}
+			double piv = x[prow[j]];
+			const vector<int> &li = Li[j];
+			vector<double> &lx = Lx[j];
+			double maxAbs = std::abs(piv);
+			for (size_t p = 0; p < li.size(); p++) {
+				maxAbs = std::max(maxAbs, std::abs(x[li[p]]));
+			}
+			bool ok = maxAbs > 0.0 && std::abs(piv) >= REUSE_DEGRADE_TOL * maxAbs;
+			if (ok) {
+				Udiag[j] = piv;
+				for (size_t p = 0; p < li.size(); p++) {
+					lx[p] = x[li[p]] / piv;
+				}
+			}
+			for (size_t t = 0; t < ui.size(); t++) {
+				x[prow[ui[t]]] = 0.0;
+			}
+			for (size_t p = 0; p < li.size(); p++) {
+				x[li[p]] = 0.0;
+			}
+			x[prow[j]] = 0.0;
+			for (uword p = A.col_ptrs[col]; p < A.col_ptrs[col + 1]; p++) {
+				x[A.row_indices[p]] = 0.0;
+			}
+			return ok;
+		}
+
+		bool CheParallelLuSolver::runColumns(const sp_mat &A, bool replay) {
+			A.sync();
+			if (pool == NULL || n < PARALLEL_MIN_SIZE) {
+				Workspace ws(n);
+				for (int j = 0; j < n; j++) {
+					if (!(replay ? refactorColumn(A, j, ws) : factorColumn(A, j, ws))) {
+						return false;
+					}
+				}
+				return true;
+			}
+
+			// Every leaf starts a chain; a column is continued by the worker finishing its last child.
+			vector<std::atomic<int>> pending(n);
+			for (int k = 0; k < n; k++) {
+				pending[k].store(nChildren[k], std::memory_order_relaxed);
+			}
+			std::mutex leafMutex;
+			size_t nextLeaf = 0;
+			std::atomic<bool> failed(false);
+			for (int w = 0; w < nThreads; w++) {
+				pool->submit([&]() {
+					Workspace ws(n);
+					while (!failed.load(std::memory_order_relaxed)) {
+						int j;
+						{
+							std::lock_guard<std::mutex> lock(leafMutex);
+							if (nextLeaf >= leaves.size()) {
+								return;
+							}
+							j = leaves[nextLeaf++];
+						}
+						while (j >= 0) {
+							if (!(replay ? refactorColumn(A, j, ws) : factorColumn(A, j, ws))) {
+								failed.store(true);
+								return;
+							}
+							int p = parent[j];
+							j = -1;
+							if (p >= 0 && pending[p].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+								j = p;
+							}
+						}
+					}
+				});
+			}
+			pool->wait();
+			return !failed.load();
+		}
+
+		bool CheParallelLuSolver::factor(const sp_mat &A) {
+			if (!analyzed || !hasSamePattern(A)) {
+				analyze(A);
+			}
+			pinv.assign(A.n_rows, -1);
+			prow.assign(n, -1);
+			Udiag.assign(n, 0.0);
+			Li.assign(n, vector<int>());
+			Lx.assign(n, vector<double>());
+			Ui.assign(n, vector<int>());
+			Ux.assign(n, vector<double>());
+			factored = runColumns(A, false);
+			stats.nFactor++;
+			return factored;
+		}
+
+		bool CheParallelLuSolver::refactor(const sp_mat &A) {
+			if (!factored || !hasSamePattern(A)) {
+				return factor(A);
+			}
+			if (runColumns(A, true)) {
+				stats.nRefactor++;
+				return true;
+			}
+			// A pivot of the old sequence became too small, factorize afresh on the same analysis.
+			pinv.assign(A.n_rows, -1);
+			prow.assign(n, -1);
+			factored = runColumns(A, false);
+			if (factored) {
+				stats.nRepivot++;
+			}
+			return factored;
+		}
+
+		void CheParallelLuSolver::solveColumn(const double *b, double *x, vector<double> &z, vector<double> &y) const {
+			std::copy(b, b + n, z.begin());
+			for (int k = 0; k < n; k++) {
+				double v = z[prow[k]];
+				y[k] = v;
+				if (v != 0.0) {
+					const vector<int> &lk = Li[k];
+					const vector<double> &lv = Lx[k];
+					for (size_t p = 0; p < lk.size(); p++) {
+						z[lk[p]] -= lv[p] * v;
+					}
+				}
+			}
+			for (int j = n - 1; j >= 0; j--) {
+				double xj = y[j] / Udiag[j];
+				x[q[j]] = xj;
+				if (xj != 0.0) {
+					const vector<int> &uj = Ui[j];
+					const vector<double> &uv = Ux[j];
+					for (size_t p = 0; p < uj.size(); p++) {
+						y[uj[p]] -= uv[p] * xj;
+					}
+				}
+			}
+		}
+
+		bool CheParallelLuSolver::solve(mat &X, const mat &B) {
+			if (!factored) {
+				return false;
+			}
+			int nRhs = B.n_cols;
+			X.set_size(n, nRhs);
+			if (pool == NULL || nRhs < 2) {
+				vector<double> z(n);
+				vector<double> y(n);
+				for (int c = 0; c < nRhs; c++) {
+					solveColumn(B.colptr(c), X.colptr(c), z, y);
+				}
+			} else {
+				int nChunk = std::min(nThreads, nRhs);
+				for (int t = 0; t < nChunk; t++) {
+					pool->submit([this, t, nChunk, nRhs, &X, &B]() {
+						vector<double> z(n);
+						vector<double> y(n);
+						for (int c = t; c < nRhs; c += nChunk) {
+							solveColumn(B.colptr(c), X.colptr(c), z, y);
+						}
+					});
+				}
+				pool->wait();
+			}
+			stats.nSolve++;
+			return true;
+		}
+
+		bool CheParallelLuSolver::isFactored() const {
+			return factored;
+		}
+
+		const char *CheParallelLuSolver::getName() const {
+			return "parallel";
+		}
+
+		// ========================== Low-rank update ==========================
+
+		CheLowRankUpdateSolver::CheLowRankUpdateSolver(CheSparseSolver *baseSolver, CheSparseSolver *fullSolver, int maxRank)
+			: baseSolver(baseSolver), fullSolver(fullSolver), maxRank(maxRank), hasBase(false), useFull(false),
+			  factored(false), dropTol(0.0) {
+		}
+
+		CheLowRankUpdateSolver::~CheLowRankUpdateSolver() {
+			delete baseSolver;
+			delete fullSolver;
+		}
+
+		bool CheLowRankUpdateSolver::analyze(const sp_mat &A) {
+			return fullSolver->analyze(A);
+		}
+
+		bool CheLowRankUpdateSolver::factor(const sp_mat &A) {
+			return update(A, false);
+		}
+
+		bool CheLowRankUpdateSolver::refactor(const sp_mat &A) {
+			return update(A, true);
+		}
+
+		void CheLowRankUpdateSolver::syncFullStats() {
+			int nLowRank = stats.nLowRank;
+			int nSolve = stats.nSolve;
+			stats = fullSolver->stats;
+			stats.nAnalyze += baseSolver->stats.nAnalyze;
+			stats.nFactor += baseSolver->stats.nFactor;
+			stats.nLowRank = nLowRank;
+			stats.nSolve = nSolve;
+		}
+
+		bool CheLowRankUpdateSolver::update(const sp_mat &A, bool reuse) {
+			factored = false;
+			updCols.reset();
+			Z.reset();
+			S.reset();
+			if (!hasBase) {
+				hasBase = baseSolver->factor(A);
+				if (hasBase) {
+					baseMatrix = A;
+					dropTol = A.n_nonzero > 0 ? 1e-12 * max(abs(nonzeros(A))) : 0.0;
+				}
+				useFull = false;
+				factored = hasBase;
+				syncFullStats();
+				return factored;
+			}
+
+			if (A.n_rows == baseMatrix.n_rows && A.n_cols == baseMatrix.n_cols) {
+				sp_mat D = A - baseMatrix;
+				D.clean(dropTol);
+				D.sync();
+				std::vector<uword> cols;
+				for (uword c = 0; c < D.n_cols && (int)cols.size() <= maxRank; c++) {
+					if (D.col_ptrs[c + 1] > D.col_ptrs[c]) {
+						cols.push_back(c);
+					}
+				}
+				if ((int)cols.size() <= maxRank) {
+					int k = cols.size();
+					bool ok = true;
+					if (k > 0) {
+						mat U(A.n_rows, k, fill::zeros);
+						for (int j = 0; j < k; j++) {
+							for (uword p = D.col_ptrs[cols[j]]; p < D.col_ptrs[cols[j] + 1]; p++) {
+								U(D.row_indices[p], j) = D.values[p];
+							}
+						}
+						updCols = conv_to<uvec>::from(cols);
+						ok = baseSolver->solve(Z, U);
+						if (ok) {
+							S = Z.rows(updCols);
+							S.diag() += 1.0;
+							ok = rcond(S) > 1e-14;
+						}
+					}
+					if (ok) {
+						useFull = false;
+						factored = true;
+						stats.nLowRank++;
+						return true;
+					}
+					// singular capacitance matrix, let the full factorization decide
+					updCols.reset();
+					Z.reset();
+					S.reset();
+				}
+			}
+
+			useFull = true;
+			factored = reuse && fullSolver->isFactored() ? fullSolver->refactor(A) : fullSolver->factor(A);
+			syncFullStats();
+			return factored;
+		}
+
+		bool CheLowRankUpdateSolver::solve(mat &X, const mat &B) {
+			if (!factored) {
+				return false;
+			}
+			stats.nSolve++;
+			if (useFull) {
+				return fullSolver->solve(X, B);
+			}
+			if (!baseSolver->solve(X, B)) {
+				return false;
+			}
+			if (updCols.n_elem > 0) {
+				mat W;
+				if (!arma::solve(W, S, mat(X.rows(updCols)))) {
+					return false;
+				}
+				X -= Z * W;
+			}
+			return true;
+		}
+
+		bool CheLowRankUpdateSolver::isFactored() const {
+			return factored;
+		}
+
+		const char *CheLowRankUpdateSolver::getName() const {
+			return "low-rank update";
+		}
+
+		int CheLowRankUpdateSolver::getRank() const {
+			if (!factored || useFull) {
+				return -1;
+			}
+			return updCols.n_elem;
+		}
+
+		// ========================== Factory ==========================
+
+		CheSparseSolver *CheSparseSolverFactory::makeSolver(int type, int nThreads) {
+			CheSparseSolver *pSolver = NULL;
+			if (type == CHESPSOLVER_SUPERLU) {
+				pSolver = new CheSuperLuSolver();
+			} else if (type == CHESPSOLVER_PARALLEL_LU) {
+				pSolver = new CheParallelLuSolver(nThreads);
+			}
+			return pSolver;
+		}
+
+		int CheSparseSolverFactory::parseSolverType(const std::string &name) {
+			if (name == "superlu") {
+				return CHESPSOLVER_SUPERLU;
+			} else if (name == "parallel") {
+				return CHESPSOLVER_PARALLEL_LU;
+			}
+			return -1;
+		}
+	} // namespace util
+} // namespace che
@@ -0,0 +1,275 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#ifndef _Che_SparseSolver_H_
+#define _Che_SparseSolver_H_
+
+#include "util/SafeArmadillo.h"
+#include "util/CheThreadPool.h"
+#include <string>
+#include <vector>
+
+using namespace arma;
+using namespace std;
+
+namespace che {
+	namespace util {
+		enum CheSparseSolverType { CHESPSOLVER_SUPERLU,
+								   CHESPSOLVER_PARALLEL_LU };
+
+		class CheSparseSolverStats {
+		public:
+			int nAnalyze = 0; // symbolic analyses (ordering, elimination tree)
+			int nFactor = 0;  // full numeric factorizations
+			int nRefactor = 0; // numeric factorizations reusing the previous pivot sequence
+			int nRepivot = 0; // refactorizations that had to pivot afresh on the saved analysis
+			int nSolve = 0;	 // solve calls (each may carry several right-hand sides)
+			int nLowRank = 0; // factorizations replaced by a low-rank update of a base factorization
+		};
+
+		/**
+		 * @brief Sparse direct solver of A * X = B with explicit phases.
+		 *
+		 * analyze() orders the columns and builds the symbolic structure of a sparsity pattern,
+		 * factor() computes a fresh numeric factorization (analyzing first if the pattern changed) and
+		 * refactor() factorizes a matrix with the pattern of the last factorization, reusing as much of
+		 * the previous work as is numerically safe. solve() accepts any number of right-hand sides.
+		 */
+		class CheSparseSolver {
+		public:
+			CheSparseSolverStats stats;
+
+			virtual ~CheSparseSolver() {}
+
+			virtual bool analyze(const sp_mat &A) = 0;
+
+			virtual bool factor(const sp_mat &A) = 0;
+
+			virtual bool refactor(const sp_mat &A) = 0;
+
+			virtual bool solve(mat &X, const mat &B) = 0;
+
+			virtual bool isFactored() const = 0;
+
+			virtual const char *getName() const = 0;
+
+			bool hasSamePattern(const sp_mat &A) const;
+
+		protected:
+			uvec patternColPtr;
+			uvec patternRowIdx;
+
+			void savePattern(const sp_mat &A);
+		};
+
+		class CheSuperLuSolver : public CheSparseSolver {
+		public:
+			CheSuperLuSolver();
+
+			virtual ~CheSuperLuSolver();
+
+			virtual bool analyze(const sp_mat &A);
+
+			virtual bool factor(const sp_mat &A);
+
+			virtual bool refactor(const sp_mat &A);
+
+			virtual bool solve(mat &X, const mat &B);
+
+			virtual bool isFactored() const;
+
+			virtual const char *getName() const;
+
+			CheSuperLuSolver(const CheSuperLuSolver &) = delete;
+
+			CheSuperLuSolver &operator=(const CheSuperLuSolver &) = delete;
+
+		private:
+			bool runGssvx(const sp_mat &A, arma::superlu::fact_t fact);
+
+			void releaseFactors();
+
+			int n;
+			bool analyzed;
+			bool factored;
+			bool luAllocated;
+			arma::superlu::superlu_options_t options;
+			arma::superlu::SuperMatrix L;
+			arma::superlu::SuperMatrix U;
+			arma::superlu::GlobalLU_t glu;
+			arma::superlu::SuperLUStat_t stat;
+			std::vector<int> permC;
+			std::vector<int> permR;
+			std::vector<int> etree;
+			std::vector<arma::superlu::int_t> colPtr; // pattern of the analyzed matrix in SuperLU's index type
+			std::vector<arma::superlu::int_t> rowIdx;
+			std::vector<double> R;
+			std::vector<double> C;
+			char equed[8];
+			double rpg;
+			double rcond;
+			double refRpg;
+			double refRcond;
+		};
+
+		/**
+		 * @brief Left-looking (Gilbert-Peierls) sparse LU with threshold partial pivoting, scheduled on a
+		 * thread pool over the column elimination tree.
+		 *
+		 * Columns are ordered by COLAMD. Columns in disjoint subtrees of the column elimination tree of
+		 * A'A touch disjoint sets of rows under any row pivoting, so every leaf starts an independent
+		 * chain and a column is factorized by the worker that finishes its last child. refactor()
+		 * replays the stored pivot sequence and L/U structure numerically.
+		 */
+		class CheParallelLuSolver : public CheSparseSolver {
+		public:
+			explicit CheParallelLuSolver(int nThreads = 0);
+
+			virtual ~CheParallelLuSolver();
+
+			virtual bool analyze(const sp_mat &A);
+
+			virtual bool factor(const sp_mat &A);
+
+			virtual bool refactor(const sp_mat &A);
+
+			virtual bool solve(mat &X, const mat &B);
+
+			virtual bool isFactored() const;
+
+			virtual const char *getName() const;
+
+			CheParallelLuSolver(const CheParallelLuSolver &) = delete;
+
+			CheParallelLuSolver &operator=(const CheParallelLuSolver &) = delete;
+
+		private:
+			class Workspace {
+			public:
+				std::vector<double> x;
+				std::vector<int> rowMark;
+				std::vector<int> stepMark;
+				std::vector<int> rowList;
+				std::vector<int> topo;
+				std::vector<int> stack;
+				std::vector<int> pstack;
+				int stamp;
+
+				explicit Workspace(int n);
+			};
+
+			bool runColumns(const sp_mat &A, bool replay);
+
+			bool factorColumn(const sp_mat &A, int j, Workspace &ws);
+
+			bool refactorColumn(const sp_mat &A, int j, Workspace &ws);
+
+			void solveColumn(const double *b, double *x, std::vector<double> &z, std::vector<double> &y) const;
+
+			int n;
+			int nThreads;
+			bool analyzed;
+			bool factored;
+			CheThreadPool *pool;
+			std::vector<int> q;		   // position -> column of A
+			std::vector<int> parent;   // column elimination tree of A(:, q)
+			std::vector<int> nChildren;
+			std::vector<int> leaves;
+			std::vector<int> pinv; // row -> pivot step
+			std::vector<int> prow; // pivot step -> row
+			std::vector<std::vector<int>> Li;
+			std::vector<std::vector<double>> Lx;
+			std::vector<std::vector<int>> Ui; // steps of U(:, j) in topological order
+			std::vector<std::vector<double>> Ux;
+			std::vector<double> Udiag;
+		};
+
+		/**
+		 * @brief Solves matrices that differ from a base matrix in a few columns with the base factorization.
+		 *
+		 * The first factor() fixes the base matrix A0 and factorizes it with baseSolver. A later matrix A whose
+		 * difference to A0 is confined to k <= maxRank columns C is not factorized: with U = (A - A0)(:, C) and
+		 * Z = A0^-1 U, solves use the Sherman-Morrison-Woodbury formula
+		 *   A^-1 b = x0 - Z (I + Z(C, :))^-1 x0(C),  x0 = A0^-1 b,
+		 * which costs k base solves per factor() and one k x k solve per solve(). Matrices with more changed
+		 * columns (or another size) are factorized by fullSolver, and the base factorization is kept for the
+		 * next matrix. Differences below 1e-12 of the largest entry of A0 are ignored.
+		 */
+		class CheLowRankUpdateSolver : public CheSparseSolver {
+		public:
+			// takes ownership of both solvers
+			CheLowRankUpdateSolver(CheSparseSolver *baseSolver, CheSparseSolver *fullSolver, int maxRank = 16);
+
+			virtual ~CheLowRankUpdateSolver();
+
+			virtual bool analyze(const sp_mat &A);
+
+			virtual bool factor(const sp_mat &A);
+
+			virtual bool refactor(const sp_mat &A);
+
+			virtual bool solve(mat &X, const mat &B);
+
+			virtual bool isFactored() const;
+
+			virtual const char *getName() const;
+
+			/** @brief Rank of the current update, -1 if the current matrix was factorized in full. */
+			int getRank() const;
+
+			CheLowRankUpdateSolver(const CheLowRankUpdateSolver &) = delete;
+
+			CheLowRankUpdateSolver &operator=(const CheLowRankUpdateSolver &) = delete;
+
+		private:
+			bool update(const sp_mat &A, bool reuse);
+
+			void syncFullStats();
+
+			CheSparseSolver *baseSolver;
+			CheSparseSolver *fullSolver;
+			int maxRank;
+			bool hasBase;
+			bool useFull;
+			bool factored;
+			sp_mat baseMatrix;
+			double dropTol;
+			uvec updCols;
+			mat Z;
+			mat S; // capacitance matrix I + Z(updCols, :)
+		};
+
+		class CheSparseSolverFactory {
+		public:
+			static CheSparseSolver *makeSolver(int type, int nThreads = 0);
+
+			// "superlu" or "parallel", returns -1 for unknown names
+			static int parseSolverType(const std::string &name);
+		};
+	} // namespace util
+} // namespace che
+
+#endif
@@ -81,35 +81,60 @@ namespace che {
 			this->vgIdx = s.vgIdx;
 		}
 
+		static const shared_ptr<const CheStateIdx> &getEmptyStateIdx() {
+			static const shared_ptr<const CheStateIdx> emptyIdx(new CheStateIdx());
+			return emptyIdx;
+		}
+
 		CheState::CheState() {
 			state = vec();
+			stateIdx = getEmptyStateIdx();
 		}
 
 		CheState::CheState(int nState) {
 			state = vec(nState, fill::zeros);
+			stateIdx = getEmptyStateIdx();
 		}
 
 		CheState::CheState(const CheState &st) {
-			this->stateIdx = CheStateIdx(st.stateIdx);
+			this->stateIdx = st.stateIdx;
 			this->state = st.state;
 		}
 
 		CheState::CheState(const chedata::PsatDataSet &psat) {
-			stateIdx = CheCompUtil::getCheStateIdx(psat);
-			state = vec(stateIdx.nState, fill::zeros);
+			stateIdx = CheCompUtil::getSharedStateIdx(psat);
+			state = vec(stateIdx->nState, fill::zeros);
 		}
 
 		CheState::CheState(const chedata::PsatDataSet &psat, const vec &state) {
-			stateIdx = CheCompUtil::getCheStateIdx(psat);
+			stateIdx = CheCompUtil::getSharedStateIdx(psat);
 			this->state = state;
 		}
 
-		vec CheState::getSubVec(uvec idx) const {
+		CheState::CheState(const chedata::PsatDataSet &psat, int blocks) {
+			stateIdx = CheCompUtil::getSharedStateIdx(psat, blocks);
+			state = vec(stateIdx->nState, fill::zeros);
+		}
+
+		CheState::CheState(const shared_ptr<const CheStateIdx> &stateIdx, const vec &state) {
+			this->stateIdx = stateIdx;
+			this->state = state;
+		}
+
+		vec CheState::getSubVec(const uvec &idx) const {
 			return state(idx);
 		}
 
-		void CheState::setSubVec(uvec idx, vec value) {
+		void CheState::setSubVec(const uvec &idx, const vec &value) {
 			state(idx) = value;
 		}
+
+		subview_col<double> CheState::getBlock(const uvec &idx) {
+			return idx.is_empty() ? state.head(0) : state.subvec(idx(0), idx(idx.n_rows - 1));
+		}
+
+		const subview_col<double> CheState::getBlock(const uvec &idx) const {
+			return idx.is_empty() ? state.head(0) : state.subvec(idx(0), idx(idx.n_rows - 1));
+		}
 	} // namespace util
 } // namespace che
\ No newline at end of file
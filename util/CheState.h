@@ -29,12 +29,30 @@
 
 #include "io/CheDataFormat.h"
 #include "SafeArmadillo.h"
+#include <memory>
 
 using namespace arma;
+using namespace std;
 using namespace che::io;
 
 namespace che {
 	namespace util {
+		// Blocks of the state vector. A calculator declares the blocks it uses and gets a compact layout
+		// with only those; CHESTATE_ALL is the legacy full layout.
+		enum CheStateBlock { CHESTATE_V = 1 << 0,		   // vr, vi
+							 CHESTATE_Q = 1 << 1,
+							 CHESTATE_P = 1 << 2,
+							 CHESTATE_IND_SLIP = 1 << 3,
+							 CHESTATE_IND_EMF = 1 << 4, // indEr1, indEm1, indEr2, indEm2
+							 CHESTATE_SYN_DELTA = 1 << 5,
+							 CHESTATE_SYN_OMEGA = 1 << 6,
+							 CHESTATE_SYN_FLUX = 1 << 7, // mEq1, mEq2, mEd1, mEd2, mPsid, mPsiq
+							 CHESTATE_SYN_PG = 1 << 8,
+							 CHESTATE_SYN_EF = 1 << 9,
+							 CHESTATE_EXC = 1 << 10,
+							 CHESTATE_TG = 1 << 11,
+							 CHESTATE_AGC = 1 << 12, // f, qplt, vg
+							 CHESTATE_ALL = (1 << 13) - 1 };
 
 		class CheStateIdx {
 		public:
@@ -103,7 +121,7 @@ namespace che {
 		class CheState {
 		public:
 			vec state;
-			CheStateIdx stateIdx;
+			shared_ptr<const CheStateIdx> stateIdx; // shared, never modified through a state
 
 			CheState();
 
@@ -111,13 +129,24 @@ namespace che {
 
 			CheState(const CheState &st);
 
+			CheState &operator=(const CheState &) = default;
+
 			CheState(const chedata::PsatDataSet &psat);
 
 			CheState(const chedata::PsatDataSet &psat, const vec &state);
 
-			vec getSubVec(uvec idx) const;
+			CheState(const chedata::PsatDataSet &psat, int blocks);
+
+			CheState(const shared_ptr<const CheStateIdx> &stateIdx, const vec &state);
+
+			vec getSubVec(const uvec &idx) const;
+
+			void setSubVec(const uvec &idx, const vec &value);
+
+			/** @brief View of a block of stateIdx, the blocks are contiguous so no gather is needed. */
+			subview_col<double> getBlock(const uvec &idx);
 
-			void setSubVec(uvec idx, vec value);
+			const subview_col<double> getBlock(const uvec &idx) const;
 		};
 	} // namespace util
 } // namespace che
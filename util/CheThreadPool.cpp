@@ -0,0 +1,110 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#include "util/CheThreadPool.h"
+
+namespace che {
+	namespace util {
+		CheThreadPool::CheThreadPool(int nThreads) : nPending(0), stopping(false) {
+			if (nThreads <= 0) {
+				nThreads = getDefaultThreadCount();
+			}
+			workers.reserve(nThreads);
+			for (int i = 0; i < nThreads; i++) {
+				workers.emplace_back(&CheThreadPool::workerLoop, this);
+			}
+		}
+
+		CheThreadPool::~CheThreadPool() {
+			{
+				std::unique_lock<std::mutex> lock(poolMutex);
+				stopping = true;
+			}
+			taskCv.notify_all();
+			for (size_t i = 0; i < workers.size(); i++) {
+				workers[i].join();
+			}
+		}
+
+		void CheThreadPool::submit(std::function<void()> task) {
+			{
+				std::unique_lock<std::mutex> lock(poolMutex);
+				tasks.push_back(std::move(task));
+				nPending++;
+			}
+			taskCv.notify_one();
+		}
+
+		void CheThreadPool::wait() {
+			std::unique_lock<std::mutex> lock(poolMutex);
+			doneCv.wait(lock, [this] { return nPending == 0; });
+			if (firstError) {
+				std::exception_ptr err = firstError;
+				firstError = nullptr;
+				std::rethrow_exception(err);
+			}
+		}
+
+		int CheThreadPool::getThreadCount() const {
+			return (int)workers.size();
+		}
+
+		int CheThreadPool::getDefaultThreadCount() {
+			unsigned int n = std::thread::hardware_concurrency();
+			return n > 0 ? (int)n : 1;
+		}
+
+		void CheThreadPool::workerLoop() {
+			while (true) {
+				std::function<void()> task;
+				{
+					std::unique_lock<std::mutex> lock(poolMutex);
+					taskCv.wait(lock, [this] { return stopping || !tasks.empty(); });
+					if (tasks.empty()) {
+						return;
+					}
+					task = std::move(tasks.front());
+					tasks.pop_front();
+				}
+				try {
+					task();
+				} catch (...) {
+					std::unique_lock<std::mutex> lock(poolMutex);
+					if (!firstError) {
+						firstError = std::current_exception();
+					}
+				}
+				{
+					std::unique_lock<std::mutex> lock(poolMutex);
+					nPending--;
+					if (nPending == 0) {
+						doneCv.notify_all();
+					}
+				}
+			}
+		}
+	} // namespace util
+} // namespace che
@@ -0,0 +1,80 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#ifndef _Che_ThreadPool_H_
+#define _Che_ThreadPool_H_
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace che {
+	namespace util {
+		/**
+		 * @brief Fixed-size thread pool with a shared task queue.
+		 *
+		 * Tasks are executed in submission order by whichever worker is free. wait() blocks until every
+		 * submitted task has finished and rethrows the first exception raised by a task.
+		 */
+		class CheThreadPool {
+		public:
+			// nThreads <= 0 uses the number of hardware threads
+			explicit CheThreadPool(int nThreads = 0);
+
+			CheThreadPool(const CheThreadPool &) = delete;
+
+			CheThreadPool &operator=(const CheThreadPool &) = delete;
+
+			virtual ~CheThreadPool();
+
+			void submit(std::function<void()> task);
+
+			void wait();
+
+			int getThreadCount() const;
+
+			static int getDefaultThreadCount();
+
+		private:
+			void workerLoop();
+
+			std::vector<std::thread> workers;
+			std::deque<std::function<void()>> tasks;
+			std::mutex poolMutex;
+			std::condition_variable taskCv;
+			std::condition_variable doneCv;
+			int nPending;
+			bool stopping;
+			std::exception_ptr firstError;
+		};
+	} // namespace util
+} // namespace che
+
+#endif
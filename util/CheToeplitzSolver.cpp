@@ -0,0 +1,271 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#include "util/CheToeplitzSolver.h"
+#include "util/CheThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace che {
+	namespace util {
+		// states per tile, the workspace of a tile stays in L1/L2 for the usual Pade orders
+		static const uword TILE_SIZE = 64;
+		// below this many states the threads cost more than they save
+		static const uword PARALLEL_MIN_STATES = 16384;
+		// |1 - epsf * epsb| below this is treated as a breakdown of the recursion
+		static const double BREAKDOWN_TOL = 1e-10;
+
+		struct CheToeplitzSolver::Workspace {
+			std::vector<double> t;
+			std::vector<double> y;
+			std::vector<double> f;
+			std::vector<double> b;
+			std::vector<double> x;
+			std::vector<double> epsf;
+			std::vector<double> epsb;
+			std::vector<double> epsx;
+			std::vector<double> alpha;
+			std::vector<unsigned char> ok;
+			std::vector<double> dense;
+			std::vector<double> rhs;
+			int nSingular;
+
+			explicit Workspace(int n) : t((2 * n - 1) * TILE_SIZE), y(n * TILE_SIZE), f(n * TILE_SIZE), b(n * TILE_SIZE),
+										x(n * TILE_SIZE), epsf(TILE_SIZE), epsb(TILE_SIZE), epsx(TILE_SIZE), alpha(TILE_SIZE),
+										ok(TILE_SIZE), dense(n * n), rhs(n), nSingular(0) {}
+		};
+
+		int CheToeplitzSolver::solve(const mat &ct, const mat &y, mat &x, int method, int nThreads) {
+			uword d = y.n_rows;
+			int n = y.n_cols;
+			x.zeros(d, n);
+			if (d == 0 || n == 0) {
+				return 0;
+			}
+			uword nTiles = (d + TILE_SIZE - 1) / TILE_SIZE;
+			int nWorkers = nThreads > 0 ? nThreads : CheThreadPool::getDefaultThreadCount();
+			if (d < PARALLEL_MIN_STATES || nWorkers < 2) {
+				Workspace ws(n);
+				for (uword tile = 0; tile < nTiles; tile++) {
+					uword s0 = tile * TILE_SIZE;
+					solveTile(ct, y, x, method, s0, std::min(TILE_SIZE, d - s0), ws);
+				}
+				return ws.nSingular;
+			}
+
+			if ((uword)nWorkers > nTiles) {
+				nWorkers = nTiles;
+			}
+			std::vector<int> nSingular(nWorkers, 0);
+			CheThreadPool pool(nWorkers);
+			for (int w = 0; w < nWorkers; w++) {
+				pool.submit([&, w]() {
+					Workspace ws(n);
+					for (uword tile = w; tile < nTiles; tile += nWorkers) {
+						uword s0 = tile * TILE_SIZE;
+						solveTile(ct, y, x, method, s0, std::min(TILE_SIZE, d - s0), ws);
+					}
+					nSingular[w] = ws.nSingular;
+				});
+			}
+			pool.wait();
+			int total = 0;
+			for (int w = 0; w < nWorkers; w++) {
+				total += nSingular[w];
+			}
+			return total;
+		}
+
+		void CheToeplitzSolver::solveTile(const mat &ct, const mat &y, mat &x, int method, uword s0, uword nTile, Workspace &ws) {
+			const uword T = TILE_SIZE;
+			int n = y.n_cols;
+			double *t = ws.t.data();
+			double *yv = ws.y.data();
+			double *F = ws.f.data();
+			double *B = ws.b.data();
+			double *X = ws.x.data();
+			unsigned char *ok = ws.ok.data();
+
+			// gather the tile into a power-major layout, so that every inner loop runs over the states
+			for (int k = 0; k < 2 * n - 1; k++) {
+				const double *src = ct.colptr(k) + s0;
+				for (uword s = 0; s < nTile; s++) {
+					t[k * T + s] = src[s];
+				}
+			}
+			for (int k = 0; k < n; k++) {
+				const double *src = y.colptr(k) + s0;
+				for (uword s = 0; s < nTile; s++) {
+					yv[k * T + s] = src[s];
+				}
+			}
+			std::fill(ws.f.begin(), ws.f.end(), 0.0);
+			std::fill(ws.b.begin(), ws.b.end(), 0.0);
+			std::fill(ws.x.begin(), ws.x.end(), 0.0);
+
+			if (method == CHETOEP_LEVINSON) {
+				double *epsf = ws.epsf.data();
+				double *epsb = ws.epsb.data();
+				double *epsx = ws.epsx.data();
+				double *af = ws.alpha.data();
+				for (uword s = 0; s < nTile; s++) {
+					double f0 = 1.0 / t[(n - 1) * T + s];
+					ok[s] = std::isfinite(f0) ? 1 : 0;
+					if (!ok[s]) {
+						f0 = 0.0;
+					}
+					F[s] = f0;
+					B[(n - 1) * T + s] = f0;
+					X[s] = yv[s] * f0;
+				}
+				for (int i = 1; i < n; i++) {
+					for (uword s = 0; s < nTile; s++) {
+						epsf[s] = 0.0;
+						epsb[s] = 0.0;
+						epsx[s] = 0.0;
+					}
+					for (int k = 0; k < i; k++) {
+						const double *tf = t + (n + i - 1 - k) * T;
+						const double *tb = t + (n - 2 - k) * T;
+						const double *fk = F + k * T;
+						const double *bk = B + (n - i + k) * T;
+						const double *xk = X + k * T;
+						for (uword s = 0; s < nTile; s++) {
+							epsf[s] += fk[s] * tf[s];
+							epsb[s] += bk[s] * tb[s];
+							epsx[s] += xk[s] * tf[s];
+						}
+					}
+					for (uword s = 0; s < nTile; s++) {
+						double den = 1.0 - epsf[s] * epsb[s];
+						if (!(std::abs(den) > BREAKDOWN_TOL)) {
+							ok[s] = 0;
+							den = 1.0;
+						}
+						af[s] = 1.0 / den;
+						epsf[s] = -epsf[s] * af[s]; // betaf
+						epsb[s] = -epsb[s] * af[s]; // alphab
+						epsx[s] = yv[i * T + s] - epsx[s];
+					}
+					// F(i) and B(n - i - 1) are still zero here, so the shifted combination needs no special ends
+					for (int k = 0; k <= i; k++) {
+						double *fk = F + k * T;
+						double *bk = B + (n - i - 1 + k) * T;
+						double *xk = X + k * T;
+						for (uword s = 0; s < nTile; s++) {
+							double fo = fk[s];
+							double bo = bk[s];
+							fk[s] = af[s] * fo + epsf[s] * bo;
+							bk[s] = epsb[s] * fo + af[s] * bo;
+							xk[s] += bk[s] * epsx[s];
+						}
+					}
+				}
+				for (uword s = 0; s < nTile; s++) {
+					for (int k = 0; k < n && ok[s]; k++) {
+						ok[s] = std::isfinite(X[k * T + s]) ? 1 : 0;
+					}
+				}
+			} else {
+				std::fill(ws.ok.begin(), ws.ok.end(), 0);
+			}
+
+			for (uword s = 0; s < nTile; s++) {
+				if (!ok[s] && !solveDense(t + s, yv + s, X + s, n, T, ws)) {
+					for (int k = 0; k < n; k++) {
+						X[k * T + s] = 0.0;
+					}
+					ws.nSingular++;
+				}
+			}
+
+			for (int k = 0; k < n; k++) {
+				double *dst = x.colptr(k) + s0;
+				for (uword s = 0; s < nTile; s++) {
+					dst[s] = X[k * T + s];
+				}
+			}
+		}
+
+		bool CheToeplitzSolver::solveDense(const double *t, const double *y, double *x, int n, uword ldt, Workspace &ws) {
+			double *a = ws.dense.data();
+			double *r = ws.rhs.data();
+			for (int c = 0; c < n; c++) {
+				for (int row = 0; row < n; row++) {
+					a[c * n + row] = t[(n - 1 + row - c) * ldt];
+				}
+			}
+			for (int row = 0; row < n; row++) {
+				r[row] = y[row * ldt];
+			}
+			// Gaussian elimination with partial pivoting
+			for (int c = 0; c < n; c++) {
+				int p = c;
+				double pmax = std::abs(a[c * n + c]);
+				for (int row = c + 1; row < n; row++) {
+					if (std::abs(a[c * n + row]) > pmax) {
+						pmax = std::abs(a[c * n + row]);
+						p = row;
+					}
+				}
+				if (!(pmax > 0.0) || !std::isfinite(pmax)) {
+					return false;
+				}
+				if (p != c) {
+					for (int cc = c; cc < n; cc++) {
+						std::swap(a[cc * n + c], a[cc * n + p]);
+					}
+					std::swap(r[c], r[p]);
+				}
+				double piv = a[c * n + c];
+				for (int row = c + 1; row < n; row++) {
+					double l = a[c * n + row] / piv;
+					if (l != 0.0) {
+						for (int cc = c + 1; cc < n; cc++) {
+							a[cc * n + row] -= l * a[cc * n + c];
+						}
+						r[row] -= l * r[c];
+					}
+				}
+			}
+			for (int row = n - 1; row >= 0; row--) {
+				double v = r[row];
+				for (int cc = row + 1; cc < n; cc++) {
+					v -= a[cc * n + row] * r[cc];
+				}
+				r[row] = v / a[row * n + row];
+				if (!std::isfinite(r[row])) {
+					return false;
+				}
+			}
+			for (int row = 0; row < n; row++) {
+				x[row * ldt] = r[row];
+			}
+			return true;
+		}
+	} // namespace util
+} // namespace che
@@ -0,0 +1,64 @@
+//
+// Copyright (C) 2022, UChicago Argonne, LLC. All rights reserved.
+//
+// Software Name: Generic Semi-Analytical Simulation Tool (GenSAS)
+// By: Argonne National Laboratory
+// OPEN SOURCE LICENSE
+//
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+//
+//
+// ******************************************************************************************************
+// DISCLAIMER
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// ***************************************************************************************************
+//
+#ifndef _Che_ToeplitzSolver_H_
+#define _Che_ToeplitzSolver_H_
+
+#include "util/SafeArmadillo.h"
+
+using namespace arma;
+using namespace std;
+
+namespace che {
+	namespace util {
+		enum CheToeplitzMethod { CHETOEP_LEVINSON,
+								 CHETOEP_DENSE };
+
+		/**
+		 * @brief Batched solver of one small Toeplitz system per state, as needed by the Pade coefficients.
+		 *
+		 * Row i of ct holds the 2n-1 entries of a Toeplitz matrix T_i with T_i(r, c) = ct(i, n - 1 + r - c),
+		 * row i of y the right-hand side. The states are processed in tiles with per-thread workspaces, so
+		 * the recursion does not allocate and runs on a thread pool for large batches. A state whose
+		 * Levinson recursion breaks down is solved again by Gaussian elimination with partial pivoting,
+		 * and a singular state gets a zero row instead of NaN.
+		 */
+		class CheToeplitzSolver {
+		public:
+			/** @brief Solves all states, nThreads <= 0 uses all hardware threads. Returns the number of singular states. */
+			static int solve(const mat &ct, const mat &y, mat &x, int method = CHETOEP_LEVINSON, int nThreads = 0);
+
+		private:
+			struct Workspace;
+
+			static void solveTile(const mat &ct, const mat &y, mat &x, int method, uword s0, uword nTile, Workspace &ws);
+
+			static bool solveDense(const double *t, const double *y, double *x, int n, uword ldt, Workspace &ws);
+		};
+	} // namespace util
+} // namespace che
+
+#endif